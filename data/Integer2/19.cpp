@@ -0,0 +1,27 @@
+/*
+Time: 2026-10-17
+Test: complexity (mul) beyond the NTT length limit
+Comment: products longer than 2^23 blocks are split into transforms that fit
+Label: huge
+std Time: 4.50s
+Time Limit: 15.00s
+*/
+
+#include "int2048.h"
+#include <sstream>
+
+sjtu::int2048 a, b;
+
+int main()
+{
+    // (10^n - 1)^2 = 10^(2n) - 2 * 10^n + 1, 即n - 1个9, 一个8, n - 1个0, 一个1
+    const int n = 38000000;
+    std::string expected = std::string(n - 1, '9') + "8" + std::string(n - 1, '0') + "1";
+    a = std::string(n, '9');
+    b = a;
+    std::ostringstream square_out, mul_out;
+    square_out << square(a);
+    mul_out << a * b;
+    std::cout << square_out.str().size() << ' ' << (square_out.str() == expected) << '\n';
+    std::cout << mul_out.str().size() << ' ' << (mul_out.str() == expected) << '\n';
+}
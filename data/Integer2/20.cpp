@@ -0,0 +1,31 @@
+/*
+Time: 2026-10-17
+Test: divexact & divisible
+Comment: powers of 2 and 5, trailing zero blocks, negative operands, 0
+std Time: 0.10s
+Time Limit: 1.00s
+*/
+
+#include "int2048.h"
+
+sjtu::int2048 a, b, c;
+
+int main()
+{
+    int n;
+    std::cin >> n;
+    for (int i = 1; i <= n; i++)
+    {
+        std::cin >> a >> b;
+        if (!a.divisible(b))
+        {
+            std::cout << 0 << '\n';
+            continue;
+        }
+        c = a;
+        c.divexact(b);
+        if (c != divexact(a, b))
+            std::cout << "mismatch" << '\n';
+        std::cout << 1 << ' ' << c << '\n';
+    }
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+/*
+Time: 2026-10-17
+Test: div_rem & divmod
+Comment: floor rounding with negative operands, divisor 0, aliased arguments
+std Time: 0.02s
+Time Limit: 1.00s
+*/
+
+#include "int2048.h"
+
+sjtu::int2048 a, b, q, r;
+
+void check(const sjtu::int2048 &x, const sjtu::int2048 &y, const char *name)
+{
+    if (x != y)
+        std::cout << "mismatch: " << name << '\n';
+}
+
+int main()
+{
+    int n;
+    std::cin >> n;
+    for (int i = 1; i <= n; i++)
+    {
+        std::cin >> a >> b;
+        q = a;
+        q.div_rem(b, r);
+        std::cout << q << ' ' << r << '\n';
+
+        std::pair<sjtu::int2048, sjtu::int2048> p = divmod(a, b);
+        check(p.first, q, "divmod quotient");
+        check(p.second, r, "divmod remainder");
+        check(a / b, q, "/");
+        check(a % b, r, "%");
+        sjtu::int2048 c = a, d = a;
+        c /= b;
+        d %= b;
+        check(c, q, "/=");
+        check(d, r, "%=");
+
+        // 除数与余数是同一个对象
+        c = a, d = b;
+        c.div_rem(d, d);
+        check(c, q, "div_rem(val, val) quotient");
+        check(d, r, "div_rem(val, val) remainder");
+
+        // 除数是当前数本身
+        sjtu::int2048 e = a, f = a, g = a, h;
+        e.div_rem(e, h);
+        f %= f;
+        g /= g;
+        std::cout << e << ' ' << h << ' ' << f << ' ' << g << '\n';
+    }
+}
\ No newline at end of file
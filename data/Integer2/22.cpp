@@ -0,0 +1,50 @@
+/*
+Time: 2026-10-17
+Test: div & mod by long long and reciprocal
+Comment: negative divisors, LLONG_MIN, 10^9, 10^18, divisor 0
+std Time: 0.01s
+Time Limit: 1.00s
+*/
+
+#include "int2048.h"
+
+sjtu::int2048 a, q, r;
+
+void check(const sjtu::int2048 &x, const sjtu::int2048 &y, const char *name)
+{
+    if (x != y)
+        std::cout << "mismatch: " << name << '\n';
+}
+
+int main()
+{
+    int n;
+    std::cin >> n;
+    for (int i = 1; i <= n; i++)
+    {
+        long long b;
+        unsigned long long d;
+        std::cin >> a >> b >> d;
+        q = a / b;
+        r = a % b;
+        sjtu::int2048 c = a;
+        long long rem = c.div_rem(b);
+        std::cout << q << ' ' << r << ' ' << rem << '\n';
+        check(c, q, "div_rem(long long)");
+
+        sjtu::int2048 e = a, f = a;
+        e /= b;
+        f %= b;
+        check(e, q, "/=");
+        check(f, r, "%=");
+
+        // 同一个倒数可以反复使用
+        sjtu::reciprocal rc(d);
+        sjtu::int2048 g = a, h = a;
+        unsigned long long rem1 = g.div_rem(rc), rem2 = h.div_rem(rc);
+        check(g, h, "div_rem(reciprocal) reused");
+        if (rem1 != rem2)
+            std::cout << "mismatch: div_rem(reciprocal) remainder" << '\n';
+        std::cout << g << ' ' << rem1 << '\n';
+    }
+}
\ No newline at end of file
@@ -1,599 +1,1928 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include <int2048.h>
 
-sjtu::polynomial::polynomial()
+// x86-64上加减法与NTT使用AVX2/AVX-512内核, 运行时检测CPU后选用
+// 定义INT2048_NO_SIMD只使用标量内核, 定义INT2048_NO_AVX512则最多使用AVX2
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(INT2048_NO_SIMD)
+#define INT2048_X86_SIMD
+#include <immintrin.h>
+#endif
+
+// 乘法算法的切换阈值(以较短乘数的block数计), 可在编译时通过-D覆盖
+// 实测中(base = 10^9)NTT在1000个block左右快于Karatsuba, 标量NTT也只晚到1500个block左右,
+// 而Toom-3要到3000个block左右才快于Karatsuba, 没有一段长度能胜过两者
+// 因此默认Toom-3阈值与NTT相同, 即默认不会用到Toom-3; 只有用-D调低INT2048_TOOM3_THRESHOLD
+// 或调高INT2048_NTT_THRESHOLD时, [TOOM3, NTT)内的乘法与平方才使用Toom-3
+#ifndef INT2048_KARATSUBA_THRESHOLD
+#define INT2048_KARATSUBA_THRESHOLD 96
+#endif
+#ifndef INT2048_TOOM3_THRESHOLD
+#define INT2048_TOOM3_THRESHOLD 1024
+#endif
+#ifndef INT2048_NTT_THRESHOLD
+#define INT2048_NTT_THRESHOLD 1024
+#endif
+// 除法算法的切换阈值(以除数和商中较短者的block数计)
+// 实测中Burnikel-Ziegler直到16000个block左右都不慢于牛顿迭代
+#ifndef INT2048_BZ_THRESHOLD
+#define INT2048_BZ_THRESHOLD 64
+#endif
+#ifndef INT2048_NEWTON_THRESHOLD
+#define INT2048_NEWTON_THRESHOLD 16384
+#endif
+// 精确除法从逐位消去切换到2-adic牛顿迭代求逆的阈值(以除数和商中较短者的block数计)
+#ifndef INT2048_HENSEL_THRESHOLD
+#define INT2048_HENSEL_THRESHOLD 1024
+#endif
+// NTT长度(系数个数)不小于此值时多线程进行变换, 线程数为0时使用std::thread::hardware_concurrency()
+#ifndef INT2048_PARALLEL_THRESHOLD
+#define INT2048_PARALLEL_THRESHOLD 65536
+#endif
+#ifndef INT2048_THREADS
+#define INT2048_THREADS 0
+#endif
+
+constexpr unsigned sjtu::polynomial::mod[];
+
+sjtu::kernel_set sjtu::active_kernel_set()
 {
-  len = 1;
-  a = new __int128 [1]{0};
+#ifdef INT2048_X86_SIMD
+  static const kernel_set ret = []
+  {
+    // 可能在其他全局对象的构造函数中被调用, 需要先初始化CPU信息
+    __builtin_cpu_init();
+#ifndef INT2048_NO_AVX512
+    if (__builtin_cpu_supports("avx512f")) return kernel_set::avx512;
+#endif
+    if (__builtin_cpu_supports("avx2")) return kernel_set::avx2;
+    return kernel_set::scalar;
+  }();
+  return ret;
+#else
+  return kernel_set::scalar;
+#endif
 }
 
-sjtu::polynomial::polynomial(const sjtu::int2048 &val)
+const char *sjtu::kernel_set_name(sjtu::kernel_set val)
 {
-  len = val.len;
-  a = new __int128 [len + 5];
-  for (int i = 0; i < val.len; ++i) a[i] = val.a[i];
+  switch (val)
+  {
+    case kernel_set::avx2: return "avx2";
+    case kernel_set::avx512: return "avx512";
+    default: return "scalar";
+  }
 }
 
-sjtu::polynomial::polynomial(const sjtu::polynomial &val)
+sjtu::montgomery::montgomery(unsigned val)
 {
-  len = val.len;
-  a = new __int128 [len + 5];
-  for (int i = 0; i < len; ++i) a[i] = val.a[i];
+  mod = val;
+  unsigned inv = val; // 牛顿迭代求mod^(-1) mod 2^32, 每次迭代精度翻倍
+  for (int i = 0; i < 4; ++i) inv *= 2 - val * inv;
+  neg_inv = -inv;
+  r2 = static_cast<unsigned>(-static_cast<unsigned long long>(val) % val); // 2^64 mod val
 }
 
-sjtu::polynomial::polynomial(sjtu::polynomial && val) noexcept
+inline unsigned sjtu::montgomery::Reduce(unsigned long long x) const
 {
-  a = val.a;
-  val.a = nullptr;
-  len = val.len;
+  unsigned m = static_cast<unsigned>(x) * neg_inv;
+  return static_cast<unsigned>((x + 1ull * m * mod) >> 32);
 }
 
-sjtu::polynomial::~polynomial()
+inline unsigned sjtu::montgomery::Mul(unsigned x, unsigned y) const
 {
-  delete [] a;
+  return Reduce(1ull * x * y);
 }
 
-sjtu::polynomial &sjtu::polynomial::operator=(sjtu::polynomial &&val) noexcept
+inline unsigned sjtu::montgomery::ToForm(unsigned x) const
 {
-  a = val.a;
-  val.a = nullptr;
-  len = val.len;
-  return *this;
+  return Mul(x % mod, r2);
 }
 
-sjtu::polynomial &sjtu::polynomial::operator=(const sjtu::polynomial &val)
+inline unsigned sjtu::montgomery::Normalize(unsigned x) const
 {
-  len = val.len;
-  delete [] a;
-  a = new __int128  [len + 5];
-  for (int i = 0; i < len; ++i) a[i] = val.a[i];
-  return *this;
+  return x >= mod ? x - mod : x;
 }
 
-void sjtu::polynomial::ExtendLen(int new_len)
+sjtu::reciprocal::reciprocal(unsigned long long val)
 {
-  auto *new_a = new __int128 [new_len + 6];
-  for (int i = 0; i < len; ++i) new_a[i] = a[i];
-  for (int i = len; i < new_len; ++i) new_a[i] = 0;
-  delete [] a;
-  a = new_a;
-  len = new_len;
+  divisor = val;
+  shift = __builtin_clzll(val);
+  unsigned long long norm = val << shift;
+  inv = static_cast<unsigned long long>(((static_cast<unsigned __int128>(~norm) << 64) | ~0ull) / norm);
 }
 
-void sjtu::polynomial::ChangeIndex()
+inline unsigned long long sjtu::reciprocal::DivRem(unsigned long long hi, unsigned long long lo,
+                                                   unsigned long long &rem) const
 {
-  int *rev;
-  rev = new int [len + 5];
-  rev[0] = 0;
-  for (int i = 1; i < len; ++i)
+  // 先将被除数与除数左移shift位, 用倒数估计商, 至多再修正两次
+  unsigned long long norm = divisor << shift;
+  if (shift != 0)
   {
-    rev[i] = (rev[i >> 1] >> 1);
-    if (i & 1) rev[i] += (len >> 1);
+    hi = (hi << shift) | (lo >> (64 - shift));
+    lo <<= shift;
   }
-  for (int i = 0; i < len; ++i)
-    if (i < rev[i]) std::swap(a[i], a[rev[i]]);
-  delete [] rev;
+  unsigned __int128 q = static_cast<unsigned __int128>(inv) * hi
+                        + ((static_cast<unsigned __int128>(hi) << 64) | lo);
+  unsigned long long q1 = static_cast<unsigned long long>(q >> 64) + 1;
+  unsigned long long q0 = static_cast<unsigned long long>(q);
+  unsigned long long r = lo - q1 * norm;
+  if (r > q0)
+  {
+    --q1;
+    r += norm;
+  }
+  if (r >= norm)
+  {
+    ++q1;
+    r -= norm;
+  }
+  rem = r >> shift;
+  return q1;
 }
 
-__int128 sjtu::pow_mod(__int128 base, __int128 pow)
+unsigned sjtu::montgomery::Pow(unsigned x, unsigned pow) const
 {
-  __int128 ret = 1, cur_pow = base;
+  unsigned ret = ToForm(1);
   while (pow > 0)
   {
-    if (pow & 1)
-    {
-      ret *= cur_pow;
-      ret %= sjtu::polynomial::mod;
-    }
-    cur_pow *= cur_pow, cur_pow %= sjtu::polynomial::mod;
+    if (pow & 1) ret = Mul(ret, x);
+    x = Mul(x, x);
     pow >>= 1;
   }
   return ret;
 }
 
-void sjtu::Extend_GCD(__int128 a, __int128 b, __int128 &x, __int128 &y)
+sjtu::polynomial::polynomial()
 {
-  if (b == 0)
-  {
-    x = 1, y = 0;
-    return;
-  }
-  Extend_GCD(b, a % b, y, x);
-  y -= x * (a / b);
+  len = 1;
+  for (int k = 0; k < mod_cnt; ++k) a[k] = new unsigned [1]{0};
 }
 
-__int128 sjtu::inverse(__int128 a)
-{
-  __int128 x, y;
-  Extend_GCD(a, sjtu::polynomial::mod, x, y);
-  x %= sjtu::polynomial::mod;
-  if (x < 0) x += sjtu::polynomial::mod;
-  return x;
-}
+sjtu::polynomial::polynomial(const sjtu::int2048 &val)
+  : polynomial(val.a, val.len) {}
 
-void sjtu::polynomial::NTT(int is_NTT)
+sjtu::polynomial::polynomial(const int *val, int val_len)
 {
-  ChangeIndex();
-  for (int step = 2; step <= len; step <<= 1)
-  {
-    __int128 w;
-    if (is_NTT == 1) { w = pow_mod(root, (mod - 1) / step); }
-    else { w = pow_mod(inv, (mod - 1) / step); }
-    for (int i = 0; i < len; i += step)
-    {
-      __int128 cur_w = 1;
-      int j = i + (step >> 1);
-      for (int k = 0; k < (step >> 1); ++k)
-      {
-        __int128 f = a[i + k], g = a[j + k];
-        a[i + k] = f + cur_w * g % mod, a[i + k] %= mod;
-        a[j + k] = f - cur_w * g % mod;
-        a[j + k] = (a[j + k] % mod + mod) % mod;
-        cur_w *= w, cur_w %= mod;
-      }
-    }
-  }
-  if (is_NTT == -1)
+  len = val_len;
+  for (int k = 0; k < mod_cnt; ++k)
   {
-    __int128 inv_len = inverse(len);
-    for (int i = 0; i < len; ++i) a[i] *= inv_len, a[i] %= mod;
+    a[k] = new unsigned [len + 5];
+    // base可能超过2 * mod[k], 需要先取模
+    for (int i = 0; i < len; ++i) a[k][i] = static_cast<unsigned>(val[i]) % mod[k];
   }
 }
 
-void sjtu::polynomial::CalcCarry()
+sjtu::polynomial::polynomial(const sjtu::polynomial &val)
 {
-  for (int i = 1; i < len; ++i)
+  len = val.len;
+  for (int k = 0; k < mod_cnt; ++k)
   {
-    a[i] += a[i - 1] / sjtu::int2048::base;
-    a[i - 1] %= sjtu::int2048::base;
+    a[k] = new unsigned [len + 5];
+    for (int i = 0; i < len; ++i) a[k][i] = val.a[k][i];
   }
 }
 
-sjtu::polynomial &sjtu::polynomial::Multiply(sjtu::polynomial val)
+sjtu::polynomial::polynomial(sjtu::polynomial && val) noexcept
 {
-  int new_len = 1;
-  while (new_len < len * 2 || new_len < val.len * 2) new_len *= 2;
-  ExtendLen(new_len);
-  val.ExtendLen(new_len);
-  NTT(1), val.NTT(1);
-  for (int i = 0; i < len; ++i) a[i] *= val.a[i], a[i] %= mod;
-  NTT(-1);
-  return *this;
+  for (int k = 0; k < mod_cnt; ++k)
+  {
+    a[k] = val.a[k];
+    val.a[k] = nullptr;
+  }
+  len = val.len;
 }
 
-sjtu::int2048 sjtu::polynomial::ToInteger()
+sjtu::polynomial::~polynomial()
 {
-  sjtu::int2048 ret;
-  delete [] ret.a;
-  ret.len = len;
-  __int128 *tmp;
-  tmp = new __int128 [len + 5];
-  ret.a = new int [len + 5];
-  CalcCarry();
-  for (int i = 0; i < len; ++i) tmp[i] = a[i];
-  while (tmp[ret.len - 1] >= sjtu::int2048::base)
-  {
-    tmp[ret.len] = tmp[ret.len - 1] / sjtu::int2048::base;
-    tmp[ret.len - 1] %= sjtu::int2048::base;
-    ++ret.len;
-  }
-  while(tmp[ret.len - 1] == 0 && ret.len >= 2) --ret.len;
-  for (int i = 0; i < ret.len; ++i) ret.a[i] = static_cast<int>(tmp[i]);
-  delete [] tmp;
-  return ret;
+  for (int k = 0; k < mod_cnt; ++k) delete [] a[k];
 }
 
-sjtu::int2048::int2048()
+sjtu::polynomial &sjtu::polynomial::operator=(sjtu::polynomial &&val) noexcept
 {
-  len = 1;
-  a = new int [1] {0};
-  sgn = 1;
+  if (this == &val) return *this;
+  for (int k = 0; k < mod_cnt; ++k)
+  {
+    delete [] a[k];
+    a[k] = val.a[k];
+    val.a[k] = nullptr;
+  }
+  len = val.len;
+  return *this;
 }
 
-sjtu::int2048::int2048(long long val)
+sjtu::polynomial &sjtu::polynomial::operator=(const sjtu::polynomial &val)
 {
-  sgn = 1;
-  if (val < 0)
-  {
-    sgn = -1;
-    val = -val;
-  }
-  len = 0;
-  long long tmp = val;
-  while (tmp)
-  {
-    ++len;
-    tmp /= base;
-  }
-  if (val == 0) len = 1; // 0 has length 1
-  a = new int [len + 5];
-  for (int i = 0; i < len; ++i)
+  if (this == &val) return *this;
+  len = val.len;
+  for (int k = 0; k < mod_cnt; ++k)
   {
-    a[i] = static_cast<int>(val % base);
-    val /= base;
+    delete [] a[k];
+    a[k] = new unsigned [len + 5];
+    for (int i = 0; i < len; ++i) a[k][i] = val.a[k][i];
   }
+  return *this;
 }
 
-sjtu::int2048::int2048(const std::string &s)
+void sjtu::polynomial::ExtendLen(int new_len)
 {
-  len = 0;
-  std::string input;
-  if (s[0] == '-')
-  {
-    sgn = -1;
-    input = s.substr(1);
-    if (input[0] == '0' && input.length() == 1) sgn = 1;
-  }
-  else
-  {
-    sgn = 1;
-    input = s;
-  }
-  int ignore_digit = 0;
-  while (input[ignore_digit] == '0' && ignore_digit != input.length() - 1)
+  for (int k = 0; k < mod_cnt; ++k)
   {
-    ++ignore_digit;
-  }
-  a = new int [input.length() / base_log10 + 5];
-  for (int i = input.length() - 1; i >= ignore_digit; i -= base_log10)
-  {
-    int cur_digit = 0, pow10 = 1;
-    for (int j = 0; j < base_log10 && i - j >= ignore_digit; ++j)
-    {
-      cur_digit += pow10 * (input[i - j] - '0');
-      pow10 *= 10;
-    }
-    a[len] = cur_digit, ++len;
+    auto *new_a = new unsigned [new_len + 6];
+    for (int i = 0; i < len; ++i) new_a[i] = a[k][i];
+    for (int i = len; i < new_len; ++i) new_a[i] = 0;
+    delete [] a[k];
+    a[k] = new_a;
   }
+  len = new_len;
 }
 
-sjtu::int2048::int2048(const sjtu::int2048 &val)
+const unsigned *sjtu::polynomial::GetRoots(int k, int is_NTT, int log)
 {
-  len = val.len;
-  sgn = val.sgn;
-  a = new int [len + 5];
-  for (int i = 0; i < len; ++i) a[i] = val.a[i];
+  // 表只会被追加, 生成后不再修改, 因此读取时无需加锁
+  static std::atomic<const unsigned *> cache[mod_cnt][2][max_log];
+  static std::mutex cache_lock;
+  std::atomic<const unsigned *> &entry = cache[k][is_NTT == 1 ? 0 : 1][log];
+  const unsigned *ret = entry.load(std::memory_order_acquire);
+  if (ret != nullptr) return ret;
+  std::lock_guard<std::mutex> guard(cache_lock);
+  ret = entry.load(std::memory_order_relaxed);
+  if (ret != nullptr) return ret;
+  const montgomery mt(mod[k]);
+  int half = 1 << log;
+  unsigned g = mt.ToForm(root);
+  if (is_NTT == -1) g = mt.Pow(g, mod[k] - 2);
+  unsigned w = mt.Pow(g, (mod[k] - 1) >> (log + 1));
+  auto *table = new unsigned [half];
+  table[0] = mt.ToForm(1);
+  for (int i = 1; i < half; ++i) table[i] = mt.Mul(table[i - 1], w);
+  entry.store(table, std::memory_order_release);
+  return table;
 }
 
-sjtu::int2048::int2048(sjtu::int2048 &&val) noexcept
+int sjtu::polynomial::ThreadCount()
 {
-  sgn = val.sgn;
-  a = val.a;
-  val.a = nullptr;
-  this->len = val.len;
+  static const int ret = INT2048_THREADS > 0 ? INT2048_THREADS
+                         : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  return ret;
 }
 
-sjtu::int2048::~int2048()
+int sjtu::polynomial::TransformThreads(int n)
 {
-  delete [] a;
+  return n >= INT2048_PARALLEL_THRESHOLD ? ThreadCount() : 1;
 }
 
-void sjtu::int2048::read(const std::string &s)
+// ThreadCount() - 1个常驻的工作线程, 首次并行计算时创建, 程序结束时回收
+// 每次ParallelFor登记一个job, 空闲的工作线程领取仍需要帮手的job, 与调用者一起从计数器中领取任务
+class sjtu::polynomial::thread_pool
 {
-  len = 0;
-  std::string input;
-  if (s[0] == '-')
+public:
+  struct job
   {
-    sgn = -1;
-    input = s.substr(1);
-    if (input.length() == 1 && input[0] == '0') sgn = 1;
-  }
-  else
+    void (*run)(const void *, int); // 执行第i个任务
+    const void *ctx;
+    int n; // 任务总数
+    std::atomic<int> next{0}; // 下一个未领取的任务
+    int wanted = 0; // 还可以加入的工作线程数
+    int running = 0; // 正在参与的工作线程数
+    std::exception_ptr error; // 第一个抛出的异常
+  };
+
+  explicit thread_pool(int n)
   {
-    sgn = 1;
-    input = s;
+    // 创建线程失败时(如资源不足)只使用已经创建好的线程, 最坏情况下所有任务都由调用者完成
+    try
+    {
+      workers.reserve(n);
+      for (int i = 0; i < n; ++i) workers.emplace_back([this] { Loop(); });
+    }
+    catch (...) {}
   }
-  delete [] a;
-  a = new int [input.length() / base_log10 + 5];
-  for (int i = input.length() - 1; i >= 0; i -= base_log10)
+
+  ~thread_pool()
   {
-    int cur_digit = 0, pow10 = 1;
-    for (int j = 0; j < base_log10 && i - j >= 0; ++j)
     {
-      cur_digit += pow10 * (input[i - j] - '0');
-      pow10 *= 10;
+      std::lock_guard<std::mutex> guard(lock);
+      stop = true;
     }
-    a[len] = cur_digit, ++len;
+    wake.notify_all();
+    for (std::thread &t : workers) t.join();
   }
-}
 
-void sjtu::int2048::print() const
-{
-  if (sgn == -1 && (len != 1 || a[0] != 0)) printf("-");
-  for (int i = len - 1; i >= 0; --i)
-    if (i != len - 1) { printf("%04d", a[i]); }
-    else { printf("%d", a[i]); }
-}
+  /// 由当前线程和至多helpers个工作线程完成task, 返回时所有参与的工作线程都已离开
+  void Run(job &task, int helpers)
+  {
+    helpers = std::min(helpers, static_cast<int>(workers.size()));
+    if (helpers > 0)
+    {
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        task.wanted = helpers;
+        jobs.push_back(&task);
+      }
+      wake.notify_all();
+    }
+    Work(task);
+    std::unique_lock<std::mutex> guard(lock);
+    // 任务已经领完, 不再接受新的工作线程, 只需等待已经加入的离开
+    auto it = std::find(jobs.begin(), jobs.end(), &task);
+    if (it != jobs.end()) jobs.erase(it);
+    done.wait(guard, [&] { return task.running == 0; });
+    if (task.error) std::rethrow_exception(task.error);
+  }
 
-std::istream &sjtu::operator>>(std::istream &input, sjtu::int2048 &x)
-{
-  std::string s;
-  input >> s;
-  x.read(s);
-  return input;
-}
+private:
+  std::mutex lock;
+  std::condition_variable wake, done;
+  std::vector<job *> jobs;
+  std::vector<std::thread> workers;
+  bool stop = false;
 
-std::ostream &sjtu::operator<<(std::ostream &output, const sjtu::int2048 &x)
-{
-  if (x.sgn == -1 && (x.len != 1 || x.a[0] != 0)) output << "-";
-  for (int i = x.len - 1; i >= 0; --i)
-    if (i != x.len - 1)
+  void Work(job &task)
+  {
+    for (int i = task.next++; i < task.n; i = task.next++)
     {
-      if (x.a[i] < 1000) output << '0';
-      if (x.a[i] < 100) output << '0';
-      if (x.a[i] < 10) output << '0';
-      output << x.a[i];
+      try
+      {
+        task.run(task.ctx, i);
+      }
+      catch (...)
+      {
+        // 记录第一个异常并放弃剩余的任务
+        std::lock_guard<std::mutex> guard(lock);
+        if (!task.error) task.error = std::current_exception();
+        task.next = task.n;
+      }
     }
-    else
+  }
+
+  void Loop()
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true)
     {
-      output << x.a[i];
+      wake.wait(guard, [&] { return stop || !jobs.empty(); });
+      if (stop) return;
+      job *task = jobs.front();
+      if (--task->wanted == 0) jobs.erase(jobs.begin());
+      ++task->running;
+      guard.unlock();
+      Work(*task);
+      guard.lock();
+      if (--task->running == 0) done.notify_all();
     }
-  return output;
-}
+  }
+};
 
-sjtu::int2048 &sjtu::int2048::operator<<=(int val)
+sjtu::polynomial::thread_pool &sjtu::polynomial::Pool()
 {
-  int *new_a = new int [len + val + 5];
-  for (int i = 0; i < len; ++i) new_a[i + val] = a[i];
-  for (int i = 0; i < val; ++i) new_a[i] = 0;
-  delete [] a;
-  a = new_a;
-  len += val;
-  return *this;
+  // 放在模板之外, 保证不同的ParallelFor实例共用同一组工作线程
+  static thread_pool pool(ThreadCount() - 1);
+  return pool;
 }
 
-sjtu::int2048 &sjtu::int2048::operator>>=(int val)
+template <class Func>
+void sjtu::polynomial::ParallelFor(int n, int threads, const Func &f)
 {
-  int *new_a = new int [len - val + 5];
-  for (int i = val; i < len; ++i) new_a[i - val] = a[i];
-  delete [] a;
-  a = new_a;
-  len -= val;
-  return *this;
+  threads = std::min(threads, n);
+  if (threads <= 1)
+  {
+    for (int i = 0; i < n; ++i) f(i);
+    return;
+  }
+  thread_pool::job task;
+  task.run = [](const void *ctx, int i) { (*static_cast<const Func *>(ctx))(i); };
+  task.ctx = &f;
+  task.n = n;
+  Pool().Run(task, threads - 1);
 }
 
-sjtu::int2048 sjtu::operator<<(sjtu::int2048 x, int val)
+void sjtu::polynomial::Butterfly(unsigned *f0, unsigned *f1, const unsigned *w, int n,
+                                 const sjtu::montgomery &mt)
 {
-  return (x <<= val);
+  static void (*const kernel)(unsigned *, unsigned *, const unsigned *, int, const montgomery &) =
+      active_kernel_set() == kernel_set::avx512 ? ButterflyAvx512
+      : active_kernel_set() == kernel_set::avx2 ? ButterflyAvx2 : ButterflyScalar;
+  kernel(f0, f1, w, n, mt);
 }
 
-sjtu::int2048 sjtu::operator>>(sjtu::int2048 x, int val)
+void sjtu::polynomial::ButterflyDif(unsigned *f0, unsigned *f1, const unsigned *w, int n,
+                                    const sjtu::montgomery &mt)
 {
-  return (x >>= val);
+  static void (*const kernel)(unsigned *, unsigned *, const unsigned *, int, const montgomery &) =
+      active_kernel_set() == kernel_set::avx512 ? ButterflyDifAvx512
+      : active_kernel_set() == kernel_set::avx2 ? ButterflyDifAvx2 : ButterflyDifScalar;
+  kernel(f0, f1, w, n, mt);
 }
 
-sjtu::int2048 sjtu::int2048::operator+() const
+inline void sjtu::polynomial::ButterflyScalar(unsigned *f0, unsigned *f1, const unsigned *w, int n,
+                                              const sjtu::montgomery &mt)
 {
-  return *this;
+  const unsigned mod2 = 2 * mt.mod;
+  for (int j = 0; j < n; ++j)
+  {
+    // 所有值均保持在[0, 2 * mod)内, 蝶形运算后再减去多余的2 * mod
+    unsigned x = f0[j], y = mt.Mul(w[j], f1[j]);
+    f0[j] = x + y >= mod2 ? x + y - mod2 : x + y;
+    f1[j] = x >= y ? x - y : x + mod2 - y;
+  }
 }
 
-sjtu::int2048 sjtu::int2048::operator-() const
+inline void sjtu::polynomial::ButterflyDifScalar(unsigned *f0, unsigned *f1, const unsigned *w, int n,
+                                                 const sjtu::montgomery &mt)
 {
-  sjtu::int2048 tmp(*this);
-  if (tmp.len == 1 && tmp.a[0] == 0)
+  const unsigned mod2 = 2 * mt.mod;
+  for (int j = 0; j < n; ++j)
   {
-    tmp.sgn = 1;
-    return tmp;
+    unsigned x = f0[j], y = f1[j];
+    f0[j] = x + y >= mod2 ? x + y - mod2 : x + y;
+    f1[j] = mt.Mul(w[j], x >= y ? x - y : x + mod2 - y);
   }
-  tmp.sgn *= -1;
-  return tmp;
 }
 
-sjtu::int2048 sjtu::abs(const int2048 &x)
+#ifdef INT2048_X86_SIMD
+// 向量版本的Montgomery乘法: 令m = (x * y mod 2^32) * mod^(-1) mod 2^32,
+// 则x * y与m * mod的低32位相同, 结果为hi(x * y) - hi(m * mod) + mod, 与标量版本模mod同余且在(0, 2 * mod)内
+// _mm*_mul_epu32只用到偶数lane, 奇数lane右移32位后另算一次
+__attribute__((target("avx2")))
+static inline __m256i MulAvx2(__m256i x, __m256i y, __m256i vmod, __m256i vinv)
 {
-  int2048 ret(x);
-  ret.sgn = 1;
-  return ret;
+  __m256i even = _mm256_mul_epu32(x, y);
+  __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32));
+  __m256i lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+  __m256i hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa);
+  __m256i m = _mm256_mullo_epi32(lo, vinv);
+  even = _mm256_mul_epu32(m, vmod);
+  odd = _mm256_mul_epu32(_mm256_srli_epi64(m, 32), vmod);
+  hi = _mm256_sub_epi32(hi, _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa));
+  return _mm256_add_epi32(hi, vmod);
 }
 
-sjtu::int2048 &sjtu::int2048::operator=(const sjtu::int2048 &val)
+// 对[0, 4 * mod)内的s, min(s, s - 2 * mod)(无符号)即为减去多余的2 * mod后的结果
+__attribute__((target("avx2")))
+static inline __m256i ReduceAvx2(__m256i x, __m256i vmod2)
 {
-  if (this == &val) return *this;
-  delete [] a;
-  len = val.len;
-  sgn = val.sgn;
-  a = new int [len + 5];
-  for (int i = 0; i < len; ++i) a[i] = val.a[i];
-  return *this;
+  return _mm256_min_epu32(x, _mm256_sub_epi32(x, vmod2));
 }
 
-sjtu::int2048 &sjtu::int2048::operator=(sjtu::int2048 &&val) noexcept
+// AVX-512不像AVX2那样移位取奇数lane: 不带掩码的_mm512_srli_epi64/_mm512_mul_epu32/_mm512_min_epu32
+// 在GCC 12的头文件中以未初始化的向量作为透传值, -Wall下会报-Wmaybe-uninitialized;
+// 改用全1掩码的maskz形式(编译结果与不带掩码的指令相同), 奇数lane用_mm512_shuffle_epi32移到偶数位置
+__attribute__((target("avx512f")))
+static inline __m512i MulAvx512(__m512i x, __m512i y, __m512i vmod, __m512i vinv)
 {
-  delete [] a;
-  a = val.a;
-  val.a = nullptr;
-  len = val.len;
-  sgn = val.sgn;
-  return *this;
+  const __mmask16 all = 0xffff, even_lanes = 0x5555, odd_lanes = 0xaaaa;
+  __m512i even = _mm512_maskz_mul_epu32(0xff, x, y);
+  __m512i odd = _mm512_maskz_mul_epu32(0xff, _mm512_maskz_shuffle_epi32(all, x, _MM_PERM_DDBB),
+                                       _mm512_maskz_shuffle_epi32(all, y, _MM_PERM_DDBB));
+  // 偶数lane的低32位在原位, 奇数lane的低32位从odd的偶数位置移过来; 高32位反之
+  __m512i lo = _mm512_mask_shuffle_epi32(even, odd_lanes, odd, _MM_PERM_CCAA);
+  __m512i hi = _mm512_mask_shuffle_epi32(odd, even_lanes, even, _MM_PERM_DDBB);
+  __m512i m = _mm512_mullo_epi32(lo, vinv);
+  even = _mm512_maskz_mul_epu32(0xff, m, vmod);
+  odd = _mm512_maskz_mul_epu32(0xff, _mm512_maskz_shuffle_epi32(all, m, _MM_PERM_DDBB), vmod);
+  hi = _mm512_sub_epi32(hi, _mm512_mask_shuffle_epi32(odd, even_lanes, even, _MM_PERM_DDBB));
+  return _mm512_add_epi32(hi, vmod);
 }
 
-bool sjtu::operator==(const sjtu::int2048 &x, const sjtu::int2048 &y)
+__attribute__((target("avx512f")))
+static inline __m512i ReduceAvx512(__m512i x, __m512i vmod2)
 {
-  if (x.sgn != y.sgn) return false;
-  if (x.len != y.len) return false;
-  for (int i = 0; i < x.len; ++i)
-    if (x.a[i] != y.a[i]) return false;
-  return true;
+  return _mm512_maskz_min_epu32(0xffff, x, _mm512_sub_epi32(x, vmod2));
 }
 
-bool sjtu::operator!=(const sjtu::int2048 &x, const sjtu::int2048 &y)
+__attribute__((target("avx2")))
+void sjtu::polynomial::ButterflyAvx2(unsigned *f0, unsigned *f1, const unsigned *w, int n,
+                                     const sjtu::montgomery &mt)
 {
-  if (x == y) { return false; }
-  else { return true; }
+  const __m256i vmod = _mm256_set1_epi32(static_cast<int>(mt.mod));
+  const __m256i vmod2 = _mm256_set1_epi32(static_cast<int>(2 * mt.mod));
+  const __m256i vinv = _mm256_set1_epi32(static_cast<int>(0u - mt.neg_inv));
+  for (int j = 0; j < n; j += 8)
+  {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(f0 + j));
+    __m256i y = MulAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(w + j)),
+                        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(f1 + j)), vmod, vinv);
+    __m256i sum = ReduceAvx2(_mm256_add_epi32(x, y), vmod2);
+    __m256i diff = ReduceAvx2(_mm256_add_epi32(_mm256_sub_epi32(x, y), vmod2), vmod2);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(f0 + j), sum);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(f1 + j), diff);
+  }
 }
 
-bool sjtu::operator<(const sjtu::int2048 &x, const sjtu::int2048 &y)
+__attribute__((target("avx2")))
+void sjtu::polynomial::ButterflyDifAvx2(unsigned *f0, unsigned *f1, const unsigned *w, int n,
+                                        const sjtu::montgomery &mt)
 {
-  if (x.sgn != y.sgn) return x.sgn < y.sgn;
-  if (x.len != y.len) return x.len * x.sgn < y.len * y.sgn;
-  for (int i = x.len - 1; i >= 0; --i)
-    if (x.a[i] != y.a[i]) return x.a[i] * x.sgn < y.a[i] * y.sgn;
-  return false;
+  const __m256i vmod = _mm256_set1_epi32(static_cast<int>(mt.mod));
+  const __m256i vmod2 = _mm256_set1_epi32(static_cast<int>(2 * mt.mod));
+  const __m256i vinv = _mm256_set1_epi32(static_cast<int>(0u - mt.neg_inv));
+  for (int j = 0; j < n; j += 8)
+  {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(f0 + j));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(f1 + j));
+    __m256i sum = ReduceAvx2(_mm256_add_epi32(x, y), vmod2);
+    __m256i diff = ReduceAvx2(_mm256_add_epi32(_mm256_sub_epi32(x, y), vmod2), vmod2);
+    diff = MulAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(w + j)), diff, vmod, vinv);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(f0 + j), sum);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(f1 + j), diff);
+  }
 }
 
-bool sjtu::operator>(const sjtu::int2048 &x, const sjtu::int2048 &y)
+__attribute__((target("avx512f")))
+void sjtu::polynomial::ButterflyAvx512(unsigned *f0, unsigned *f1, const unsigned *w, int n,
+                                       const sjtu::montgomery &mt)
 {
-  if (x.sgn != y.sgn) return x.sgn > y.sgn;
-  if (x.len != y.len) return x.len * x.sgn > y.len * y.sgn;
-  for (int i = x.len - 1; i >= 0; --i)
-    if (x.a[i] != y.a[i]) return x.a[i] * x.sgn > y.a[i] * y.sgn;
-  return false;
+  const __m512i vmod = _mm512_set1_epi32(static_cast<int>(mt.mod));
+  const __m512i vmod2 = _mm512_set1_epi32(static_cast<int>(2 * mt.mod));
+  const __m512i vinv = _mm512_set1_epi32(static_cast<int>(0u - mt.neg_inv));
+  for (int j = 0; j < n; j += 16)
+  {
+    __m512i x = _mm512_loadu_si512(f0 + j);
+    __m512i y = MulAvx512(_mm512_loadu_si512(w + j), _mm512_loadu_si512(f1 + j), vmod, vinv);
+    _mm512_storeu_si512(f0 + j, ReduceAvx512(_mm512_add_epi32(x, y), vmod2));
+    _mm512_storeu_si512(f1 + j, ReduceAvx512(_mm512_add_epi32(_mm512_sub_epi32(x, y), vmod2), vmod2));
+  }
 }
 
-bool sjtu::operator<=(const sjtu::int2048 &x, const sjtu::int2048 &y)
+__attribute__((target("avx512f")))
+void sjtu::polynomial::ButterflyDifAvx512(unsigned *f0, unsigned *f1, const unsigned *w, int n,
+                                          const sjtu::montgomery &mt)
 {
-  if (x > y) { return false; }
-  else { return true; }
+  const __m512i vmod = _mm512_set1_epi32(static_cast<int>(mt.mod));
+  const __m512i vmod2 = _mm512_set1_epi32(static_cast<int>(2 * mt.mod));
+  const __m512i vinv = _mm512_set1_epi32(static_cast<int>(0u - mt.neg_inv));
+  for (int j = 0; j < n; j += 16)
+  {
+    __m512i x = _mm512_loadu_si512(f0 + j), y = _mm512_loadu_si512(f1 + j);
+    __m512i diff = ReduceAvx512(_mm512_add_epi32(_mm512_sub_epi32(x, y), vmod2), vmod2);
+    _mm512_storeu_si512(f0 + j, ReduceAvx512(_mm512_add_epi32(x, y), vmod2));
+    _mm512_storeu_si512(f1 + j, MulAvx512(_mm512_loadu_si512(w + j), diff, vmod, vinv));
+  }
+}
+#else
+void sjtu::polynomial::ButterflyAvx2(unsigned *f0, unsigned *f1, const unsigned *w, int n,
+                                     const sjtu::montgomery &mt)
+{
+  ButterflyScalar(f0, f1, w, n, mt);
 }
 
-bool sjtu::operator>=(const sjtu::int2048 &x, const sjtu::int2048 &y)
+void sjtu::polynomial::ButterflyDifAvx2(unsigned *f0, unsigned *f1, const unsigned *w, int n,
+                                        const sjtu::montgomery &mt)
 {
-  if (x < y) { return false; }
-  else { return true; }
+  ButterflyDifScalar(f0, f1, w, n, mt);
 }
 
-sjtu::int2048 sjtu::UnsignedAdd(const sjtu::int2048 &x, const sjtu::int2048 &y)
+void sjtu::polynomial::ButterflyAvx512(unsigned *f0, unsigned *f1, const unsigned *w, int n,
+                                       const sjtu::montgomery &mt)
 {
-  sjtu::int2048 ans;
-  ans.sgn = 1;
-  ans.len = std::max(x.len, y.len);
-  delete [] ans.a;
-  ans.a = new int [ans.len + 5];
-  for (int i = 0; i < x.len; ++i) ans.a[i] = x.a[i];
-  for (int i = x.len; i < ans.len + 5; ++i) ans.a[i] = 0;
-  for (int i = 0; i < y.len; ++i) ans.a[i] += y.a[i];
-  for (int i = 1; i < ans.len; ++i)
-  {
-    ans.a[i] += ans.a[i - 1] / sjtu::int2048::base;
-    ans.a[i - 1] %= sjtu::int2048::base;
-  }
-  if (ans.a[ans.len - 1] >= sjtu::int2048::base)
-  {
-    ans.a[ans.len] = ans.a[ans.len - 1] / sjtu::int2048::base;
-    ans.a[ans.len - 1] %= sjtu::int2048::base;
-    ++ans.len;
-  }
-  return ans;
+  ButterflyScalar(f0, f1, w, n, mt);
 }
 
-sjtu::int2048 sjtu::UnsignedMinus(const sjtu::int2048 &x, const sjtu::int2048 &y)
+void sjtu::polynomial::ButterflyDifAvx512(unsigned *f0, unsigned *f1, const unsigned *w, int n,
+                                          const sjtu::montgomery &mt)
 {
-  sjtu::int2048 ans(x);
-  ans.sgn = 1;
-  int borrow = 0;
-  for (int i = 0; i < y.len; ++i)
+  ButterflyDifScalar(f0, f1, w, n, mt);
+}
+#endif
+
+void sjtu::polynomial::Stages(unsigned *f, int n, int k, int is_NTT, const sjtu::montgomery &mt)
+{
+  // 深度优先的顺序使每个子问题在完成之前一直留在缓存中, 较大的层每遍合并两层, 流过内存的次数减半
+  if (n >= 4 * block_len)
   {
-    ans.a[i] -= borrow, borrow = 0;
-    if (ans.a[i] < y.a[i])
-    {
-      ans.a[i] = ans.a[i] + sjtu::int2048::base - y.a[i];
-      borrow = 1;
-    }
-    else
+    int h = n / 4, log = __builtin_ctz(h);
+    for (int i = 0; i < 4; ++i) Stages(f + i * h, h, k, is_NTT, mt);
+    // 第一层对(0, 1), (2, 3)两段做蝶形运算, 第二层对(0, 2), (1, 3)两段做, 后者的单位根下标相差h
+    const unsigned *w1 = GetRoots(k, is_NTT, log), *w2 = GetRoots(k, is_NTT, log + 1);
+    for (int j = 0; j < h; j += radix4_chunk)
     {
-      ans.a[i] -= y.a[i];
+      Butterfly(f + j, f + h + j, w1 + j, radix4_chunk, mt);
+      Butterfly(f + 2 * h + j, f + 3 * h + j, w1 + j, radix4_chunk, mt);
+      Butterfly(f + j, f + 2 * h + j, w2 + j, radix4_chunk, mt);
+      Butterfly(f + h + j, f + 3 * h + j, w2 + h + j, radix4_chunk, mt);
     }
+    return;
   }
-  int cur_digit = y.len;
-  while(cur_digit < ans.len && borrow != 0)
+  if (n > block_len)
   {
-    if (ans.a[cur_digit] == 0) { ans.a[cur_digit] = sjtu::int2048::base - 1; }
-    else
+    int h = n / 2;
+    Stages(f, h, k, is_NTT, mt);
+    Stages(f + h, h, k, is_NTT, mt);
+    Butterfly(f, f + h, GetRoots(k, is_NTT, __builtin_ctz(h)), h, mt);
+    return;
+  }
+  for (int log = 0; (1 << log) < n; ++log)
+  {
+    const unsigned *wn = GetRoots(k, is_NTT, log);
+    int half = 1 << log, step = half << 1;
+    // 较短的组直接内联标量版本, 避免每组一次间接调用
+    for (int i = 0; i < n; i += step)
     {
-      --ans.a[cur_digit], borrow = 0;
+      if (half >= 16) Butterfly(f + i, f + i + half, wn, half, mt);
+      else ButterflyScalar(f + i, f + i + half, wn, half, mt);
     }
-    ++cur_digit;
   }
-  while (ans.a[ans.len - 1] == 0 && ans.len >= 2) --ans.len;
-  return ans;
 }
 
-sjtu::int2048 &sjtu::int2048::add(const sjtu::int2048 &val)
+void sjtu::polynomial::StagesDif(unsigned *f, int n, int k, int is_NTT, const sjtu::montgomery &mt)
 {
-  if (sgn == -1)
+  // 与Stages的顺序完全相反: 先合并做最高的两层, 再递归处理各子段
+  if (n >= 4 * block_len)
   {
-    if (val.sgn == -1)
+    int h = n / 4, log = __builtin_ctz(h);
+    const unsigned *w1 = GetRoots(k, is_NTT, log), *w2 = GetRoots(k, is_NTT, log + 1);
+    for (int j = 0; j < h; j += radix4_chunk)
     {
-      return *this = -sjtu::UnsignedAdd(*this, val);
+      ButterflyDif(f + j, f + 2 * h + j, w2 + j, radix4_chunk, mt);
+      ButterflyDif(f + h + j, f + 3 * h + j, w2 + h + j, radix4_chunk, mt);
+      ButterflyDif(f + j, f + h + j, w1 + j, radix4_chunk, mt);
+      ButterflyDif(f + 2 * h + j, f + 3 * h + j, w1 + j, radix4_chunk, mt);
     }
-    else
+    for (int i = 0; i < 4; ++i) StagesDif(f + i * h, h, k, is_NTT, mt);
+    return;
+  }
+  if (n > block_len)
+  {
+    int h = n / 2;
+    ButterflyDif(f, f + h, GetRoots(k, is_NTT, __builtin_ctz(h)), h, mt);
+    StagesDif(f, h, k, is_NTT, mt);
+    StagesDif(f + h, h, k, is_NTT, mt);
+    return;
+  }
+  for (int log = __builtin_ctz(n) - 1; log >= 0; --log)
+  {
+    const unsigned *wn = GetRoots(k, is_NTT, log);
+    int half = 1 << log, step = half << 1;
+    for (int i = 0; i < n; i += step)
     {
-      if (-(*this) <= val)
-      {
-        return *this = sjtu::UnsignedMinus(val, *this);
-      }
-      else
-      {
-        return *this = -sjtu::UnsignedMinus(*this, val);
-      }
+      if (half >= 16) ButterflyDif(f + i, f + i + half, wn, half, mt);
+      else ButterflyDifScalar(f + i, f + i + half, wn, half, mt);
     }
   }
-  else
+}
+
+void sjtu::polynomial::NTT(int is_NTT, int threads)
+{
+  // 把每个模数下的数组分成parts段, 三个模数共mod_cnt * parts个任务:
+  // 组长不超过段长的各层只在段内进行, 各段互不影响;
+  // 组长超过段长的每一层把所有蝶形运算平均切成parts份, 每份落在同一组内. 每一步之间等待所有任务完成
+  // 正变换(DIF)先做跨段的各层再做段内的各层, 逆变换(DIT)相反
+  int parts = 1;
+  while (parts < threads && len / parts >= 128) parts *= 2;
+  int part_len = len / parts, tasks = mod_cnt * parts;
+  int piece = part_len / 2; // 每份的蝶形运算个数, 至少为32, 满足向量内核的要求
+  auto cross_stage = [&](int half)
   {
-    if (val.sgn == 1)
+    int log = __builtin_ctz(half);
+    ParallelFor(tasks, threads, [&](int id)
     {
-      return *this = sjtu::UnsignedAdd(*this, val);
-    }
-    else
+      int k = id / parts, start = id % parts * piece;
+      int i = start / half * half * 2, j = start % half;
+      const unsigned *wn = GetRoots(k, is_NTT, log) + j;
+      if (is_NTT == 1) ButterflyDif(a[k] + i + j, a[k] + i + half + j, wn, piece, montgomery(mod[k]));
+      else Butterfly(a[k] + i + j, a[k] + i + half + j, wn, piece, montgomery(mod[k]));
+    });
+  };
+  auto local_stages = [&]
+  {
+    ParallelFor(tasks, threads, [&](int id)
     {
-      if (*this >= -val)
-      {
-        return *this = sjtu::UnsignedMinus(*this, val);
-      }
-      else
-      {
-        return *this = -sjtu::UnsignedMinus(val, *this);
-      }
+      int k = id / parts;
+      unsigned *f = a[k] + id % parts * part_len;
+      if (is_NTT == 1) StagesDif(f, part_len, k, is_NTT, montgomery(mod[k]));
+      else Stages(f, part_len, k, is_NTT, montgomery(mod[k]));
+    });
+  };
+  if (is_NTT == 1)
+  {
+    for (int half = len / 2; half >= part_len; half /= 2) cross_stage(half);
+    local_stages();
+    return;
+  }
+  local_stages();
+  for (int half = part_len; half < len; half *= 2) cross_stage(half);
+  ParallelFor(tasks, threads, [&](int id)
+  {
+    int k = id / parts, from = id % parts * part_len;
+    const montgomery mt(mod[k]);
+    // len整除mod - 1, 故len^(-1) = mod - (mod - 1) / len
+    unsigned inv_len = mt.ToForm(mod[k] - (mod[k] - 1) / len);
+    for (int i = from; i < from + part_len; ++i) a[k][i] = mt.Mul(a[k][i], inv_len);
+  });
+}
+
+unsigned __int128 sjtu::polynomial::CRT(int i) const
+{
+  // Garner算法: x = r0 + mod[0] * k1 + mod[0] * mod[1] * k2
+  unsigned long long r0 = montgomery(mod[0]).Normalize(a[0][i]);
+  unsigned long long r1 = montgomery(mod[1]).Normalize(a[1][i]);
+  unsigned long long r2 = montgomery(mod[2]).Normalize(a[2][i]);
+  unsigned long long k1 = (r1 + mod[1] - r0 % mod[1]) * inv0_1 % mod[1];
+  unsigned long long x01 = r0 + k1 * mod[0];
+  unsigned long long k2 = (r2 + mod[2] - x01 % mod[2]) * inv01_2 % mod[2];
+  return x01 + static_cast<unsigned __int128>(k2) * mod01;
+}
+
+sjtu::polynomial &sjtu::polynomial::Multiply(sjtu::polynomial val)
+{
+  int new_len = 1;
+  while (new_len < len + val.len - 1) new_len *= 2;
+  PrepareBoth(val, new_len);
+  return PointwiseMultiply(val);
+}
+
+void sjtu::polynomial::Prepare(int new_len)
+{
+  ExtendLen(new_len);
+  NTT(1, TransformThreads(new_len));
+}
+
+void sjtu::polynomial::PrepareBoth(sjtu::polynomial &val, int new_len)
+{
+  // 两次正变换互不依赖, 各用一半的线程同时进行, 总线程数不超过一次变换可用的线程数
+  int threads = TransformThreads(new_len);
+  ParallelFor(2, threads, [&](int i)
+  {
+    polynomial &p = (i == 0) ? *this : val;
+    p.ExtendLen(new_len);
+    p.NTT(1, std::max(1, threads / 2));
+  });
+}
+
+sjtu::polynomial &sjtu::polynomial::PointwiseMultiply(const sjtu::polynomial &val)
+{
+  int threads = TransformThreads(len);
+  int parts = std::min(threads, len / 64 + 1);
+  int part_len = (len + parts - 1) / parts;
+  ParallelFor(mod_cnt * parts, threads, [&](int id)
+  {
+    int k = id / parts, from = id % parts * part_len, to = std::min(from + part_len, len);
+    const montgomery mt(mod[k]);
+    // 两次Montgomery乘法中多出的R^(-1)由r2抵消
+    for (int i = from; i < to; ++i)
+      a[k][i] = mt.Mul(mt.Mul(a[k][i], val.a[k][i]), mt.r2);
+  });
+  NTT(-1, threads);
+  return *this;
+}
+
+sjtu::polynomial &sjtu::polynomial::MultiplyPrepared(const sjtu::polynomial &val)
+{
+  Prepare(val.len);
+  return PointwiseMultiply(val);
+}
+
+sjtu::polynomial &sjtu::polynomial::MultiplyCyclic(sjtu::polynomial val, int n)
+{
+  PrepareBoth(val, n);
+  return PointwiseMultiply(val);
+}
+
+sjtu::polynomial &sjtu::polynomial::Square()
+{
+  int new_len = 1;
+  while (new_len < 2 * len - 1) new_len *= 2;
+  Prepare(new_len);
+  return PointwiseMultiply(*this);
+}
+
+sjtu::int2048 sjtu::polynomial::ToInteger()
+{
+  sjtu::int2048 ret;
+  ret.Allocate(len + 5);
+  // __int128除以常数会调用库函数, 因此把carry拆成高低64位:
+  // 高位直接除以base(编译为乘法), 余数与低位组成的128位数用预先求逆的reciprocal除
+  const reciprocal rec(sjtu::int2048::base);
+  unsigned __int128 carry = 0;
+  int i = 0;
+  while (i < len || carry != 0)
+  {
+    // 乘积的最高位可能恰好超出多项式的长度
+    if (i < len) carry += CRT(i);
+    unsigned long long hi = static_cast<unsigned long long>(carry >> 64), rem;
+    unsigned long long lo = rec.DivRem(hi % sjtu::int2048::base, static_cast<unsigned long long>(carry), rem);
+    ret.a[i++] = static_cast<int>(rem);
+    carry = (static_cast<unsigned __int128>(hi / sjtu::int2048::base) << 64) | lo;
+  }
+  ret.len = std::max(i, 1);
+  while(ret.a[ret.len - 1] == 0 && ret.len >= 2) --ret.len;
+  return ret;
+}
+
+void sjtu::int2048::Allocate(int n)
+{
+  if (n <= cap) return;
+  Release();
+  a = new int [n];
+  cap = n;
+}
+
+void sjtu::int2048::Release()
+{
+  if (a != small) delete [] a;
+  a = small;
+  cap = small_len;
+}
+
+void sjtu::int2048::Reserve(int n)
+{
+  if (n <= cap) return;
+  int *new_a = new int [n];
+  for (int i = 0; i < len; ++i) new_a[i] = a[i];
+  if (a != small) delete [] a;
+  a = new_a;
+  cap = n;
+}
+
+void sjtu::int2048::Grow(int n)
+{
+  if (n > cap) Reserve(std::max(n, 2 * cap));
+}
+
+void sjtu::int2048::reserve(int n)
+{
+  Reserve((n + base_log10 - 1) / base_log10);
+}
+
+sjtu::int2048::int2048()
+{
+  len = 1;
+  a = small;
+  cap = small_len;
+  a[0] = 0;
+  sgn = 1;
+}
+
+sjtu::int2048::int2048(long long val)
+{
+  sgn = 1;
+  if (val < 0)
+  {
+    sgn = -1;
+    val = -val;
+  }
+  len = 0;
+  long long tmp = val;
+  while (tmp)
+  {
+    ++len;
+    tmp /= base;
+  }
+  if (val == 0) len = 1; // 0 has length 1
+  a = small;
+  cap = small_len;
+  for (int i = 0; i < len; ++i)
+  {
+    a[i] = static_cast<int>(val % base);
+    val /= base;
+  }
+}
+
+sjtu::int2048::int2048(const std::string &s)
+{
+  a = small;
+  cap = small_len;
+  Parse(s.data(), static_cast<int>(s.length()));
+}
+
+sjtu::int2048::int2048(const sjtu::int2048 &val)
+{
+  len = val.len;
+  sgn = val.sgn;
+  a = small;
+  cap = small_len;
+  Allocate(len);
+  for (int i = 0; i < len; ++i) a[i] = val.a[i];
+}
+
+sjtu::int2048::int2048(sjtu::int2048 &&val) noexcept
+{
+  sgn = val.sgn;
+  len = val.len;
+  a = small;
+  cap = small_len;
+  if (val.a == val.small)
+  {
+    for (int i = 0; i < len; ++i) small[i] = val.small[i];
+  }
+  else
+  {
+    a = val.a;
+    cap = val.cap;
+  }
+  // 被移动的对象置为0
+  val.a = val.small;
+  val.cap = small_len;
+  val.a[0] = 0;
+  val.len = 1;
+  val.sgn = 1;
+}
+
+sjtu::int2048::~int2048()
+{
+  Release();
+}
+
+int sjtu::int2048::ParseBlock(const char *s, int n)
+{
+  int ret = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if (n >= 8)
+  {
+    // SWAR: 一次把8个ASCII数字合并为一个整数, s[0]在最低字节上, 是最高位
+    unsigned long long x;
+    memcpy(&x, s, 8);
+    x -= 0x3030303030303030ull;
+    x = (x * 10 + (x >> 8)) & 0x00ff00ff00ff00ffull;
+    x = (x * 100 + (x >> 16)) & 0x0000ffff0000ffffull;
+    x = (x * 10000 + (x >> 32)) & 0xffffffffull;
+    ret = static_cast<int>(x);
+    s += 8, n -= 8;
+  }
+#endif
+  for (int i = 0; i < n; ++i) ret = ret * 10 + (s[i] - '0');
+  return ret;
+}
+
+void sjtu::int2048::Parse(const char *s, int n)
+{
+  sgn = 1;
+  if (n > 0 && s[0] == '-')
+  {
+    sgn = -1;
+    ++s, --n;
+  }
+  while (n > 1 && s[0] == '0') ++s, --n;
+  if (n == 0)
+  {
+    len = 1, a[0] = 0, sgn = 1;
+    return;
+  }
+  Allocate((n + base_log10 - 1) / base_log10);
+  len = 0;
+  // 从低位开始每base_log10个数字组成一个block, 最高的block可能不满
+  for (int i = n; i > 0; i -= base_log10)
+  {
+    int cnt = std::min(i, static_cast<int>(base_log10));
+    a[len++] = ParseBlock(s + i - cnt, cnt);
+  }
+  if (len == 1 && a[0] == 0) sgn = 1;
+}
+
+void sjtu::int2048::read(const std::string &s)
+{
+  Parse(s.data(), static_cast<int>(s.length()));
+}
+
+void sjtu::int2048::FormatBlock(char *s, int x, int n)
+{
+  static const char digit_pairs[] =
+      "0001020304050607080910111213141516171819"
+      "2021222324252627282930313233343536373839"
+      "4041424344454647484950515253545556575859"
+      "6061626364656667686970717273747576777879"
+      "8081828384858687888990919293949596979899";
+  char *p = s + n;
+  for (; n >= 2; n -= 2)
+  {
+    p -= 2;
+    memcpy(p, digit_pairs + 2 * (x % 100), 2);
+    x /= 100;
+  }
+  if (n == 1) *--p = static_cast<char>('0' + x);
+}
+
+int sjtu::int2048::Format(char *s) const
+{
+  char *p = s;
+  if (sgn == -1 && (len != 1 || a[0] != 0)) *p++ = '-';
+  // 最高的block不补前导0, 其余的block补足base_log10位
+  int top = 1;
+  for (int x = a[len - 1]; x >= 10; x /= 10) ++top;
+  FormatBlock(p, a[len - 1], top);
+  p += top;
+  for (int i = len - 2; i >= 0; --i)
+  {
+    FormatBlock(p, a[i], base_log10);
+    p += base_log10;
+  }
+  return static_cast<int>(p - s);
+}
+
+char *sjtu::int2048::format(char *first, char *last) const
+{
+  int top = 1;
+  for (int x = a[len - 1]; x >= 10; x /= 10) ++top;
+  long long need = top + 1ll * (len - 1) * base_log10;
+  if (sgn == -1 && (len != 1 || a[0] != 0)) ++need;
+  if (last - first < need) return nullptr;
+  return first + Format(first);
+}
+
+void sjtu::int2048::print() const
+{
+  char buf[format_buf_len];
+  int n = len * base_log10 + 1;
+  char *s = (n <= format_buf_len) ? buf : new char [n];
+  fwrite(s, 1, Format(s), stdout);
+  if (s != buf) delete [] s;
+}
+
+const char *sjtu::int2048::parse(const char *first, const char *last)
+{
+  const char *p = first;
+  if (p != last && *p == '-') ++p;
+  const char *digits = p;
+  while (p != last && *p >= '0' && *p <= '9') ++p;
+  if (p == digits) return first;
+  Parse(first, static_cast<int>(p - first));
+  return p;
+}
+
+std::istream &sjtu::operator>>(std::istream &input, sjtu::int2048 &x)
+{
+  std::istream::sentry guard(input); // 跳过前缀空白
+  if (!guard) return input;
+  std::streambuf *buf = input.rdbuf();
+  const int eof = std::char_traits<char>::eof();
+  int c = buf->sgetc();
+  int sgn = 1;
+  if (c == '-')
+  {
+    sgn = -1;
+    c = buf->snextc();
+  }
+  // 直接从流的缓冲区中逐个取出数字, 从高位开始每base_log10个数字组成一个block
+  bool has_digit = false;
+  while (c == '0')
+  {
+    has_digit = true;
+    c = buf->snextc();
+  }
+  x.len = 0;
+  int cur = 0, cnt = 0;
+  while (c != eof && c >= '0' && c <= '9')
+  {
+    cur = cur * 10 + (c - '0');
+    if (++cnt == sjtu::int2048::base_log10)
+    {
+      x.Grow(x.len + 1);
+      x.a[x.len++] = cur;
+      cur = cnt = 0;
     }
+    c = buf->snextc();
   }
+  if (c == eof) input.setstate(std::ios::eofbit);
+  if (!has_digit && x.len == 0 && cnt == 0)
+  {
+    x.len = 1, x.a[0] = 0, x.sgn = 1;
+    input.setstate(std::ios::failbit);
+    return input;
+  }
+  // 最后一个block不满时补0, 使整个数变为x * 10^shift, 之后再整体除掉
+  int shift = 0;
+  if (cnt != 0)
+  {
+    shift = sjtu::int2048::base_log10 - cnt;
+    x.Grow(x.len + 1);
+    x.a[x.len++] = cur * sjtu::Pow10(shift);
+  }
+  if (x.len == 0) x.a[x.len++] = 0;
+  std::reverse(x.a, x.a + x.len);
+  x.sgn = sgn;
+  if (shift != 0) x.DivideExactSmall(sjtu::Pow10(shift));
+  if (x.len == 1 && x.a[0] == 0) x.sgn = 1;
+  return input;
+}
+
+std::ostream &sjtu::operator<<(std::ostream &output, const sjtu::int2048 &x)
+{
+  char buf[sjtu::int2048::format_buf_len];
+  int n = x.len * sjtu::int2048::base_log10 + 1;
+  char *s = (n <= sjtu::int2048::format_buf_len) ? buf : new char [n];
+  output.write(s, x.Format(s));
+  if (s != buf) delete [] s;
+  return output;
+}
+
+sjtu::int2048 &sjtu::int2048::operator<<=(int val)
+{
+  if (len == 1 && a[0] == 0) return *this;
+  Reserve(len + val);
+  for (int i = len - 1; i >= 0; --i) a[i + val] = a[i];
+  for (int i = 0; i < val; ++i) a[i] = 0;
+  len += val;
+  return *this;
+}
+
+sjtu::int2048 &sjtu::int2048::operator>>=(int val)
+{
+  // 右移不需要新的空间, 直接在原地移动
+  if (val >= len)
+  {
+    len = 1, a[0] = 0, sgn = 1;
+    return *this;
+  }
+  for (int i = val; i < len; ++i) a[i - val] = a[i];
+  len -= val;
+  return *this;
+}
+
+sjtu::int2048 sjtu::operator<<(sjtu::int2048 x, int val)
+{
+  return (x <<= val);
+}
+
+sjtu::int2048 sjtu::operator>>(sjtu::int2048 x, int val)
+{
+  return (x >>= val);
+}
+
+sjtu::int2048 sjtu::int2048::operator+() const
+{
+  return *this;
+}
+
+sjtu::int2048 sjtu::int2048::operator-() const
+{
+  sjtu::int2048 tmp(*this);
+  if (tmp.len == 1 && tmp.a[0] == 0)
+  {
+    tmp.sgn = 1;
+    return tmp;
+  }
+  tmp.sgn *= -1;
+  return tmp;
+}
+
+sjtu::int2048 sjtu::abs(const int2048 &x)
+{
+  int2048 ret(x);
+  ret.sgn = 1;
+  return ret;
+}
+
+sjtu::int2048 &sjtu::int2048::operator=(const sjtu::int2048 &val)
+{
+  if (this == &val) return *this;
+  Allocate(val.len);
+  len = val.len;
+  sgn = val.sgn;
+  for (int i = 0; i < len; ++i) a[i] = val.a[i];
+  return *this;
+}
+
+sjtu::int2048 &sjtu::int2048::operator=(sjtu::int2048 &&val) noexcept
+{
+  if (this == &val) return *this;
+  Release();
+  len = val.len;
+  sgn = val.sgn;
+  if (val.a == val.small)
+  {
+    for (int i = 0; i < len; ++i) small[i] = val.small[i];
+  }
+  else
+  {
+    a = val.a;
+    cap = val.cap;
+  }
+  val.a = val.small;
+  val.cap = small_len;
+  val.a[0] = 0;
+  val.len = 1;
+  val.sgn = 1;
+  return *this;
+}
+
+bool sjtu::operator==(const sjtu::int2048 &x, const sjtu::int2048 &y)
+{
+  if (x.sgn != y.sgn) return false;
+  if (x.len != y.len) return false;
+  for (int i = 0; i < x.len; ++i)
+    if (x.a[i] != y.a[i]) return false;
+  return true;
+}
+
+bool sjtu::operator!=(const sjtu::int2048 &x, const sjtu::int2048 &y)
+{
+  if (x == y) { return false; }
+  else { return true; }
+}
+
+bool sjtu::operator<(const sjtu::int2048 &x, const sjtu::int2048 &y)
+{
+  if (x.sgn != y.sgn) return x.sgn < y.sgn;
+  if (x.len != y.len) return x.len * x.sgn < y.len * y.sgn;
+  for (int i = x.len - 1; i >= 0; --i)
+    if (x.a[i] != y.a[i]) return x.a[i] * x.sgn < y.a[i] * y.sgn;
+  return false;
+}
+
+bool sjtu::operator>(const sjtu::int2048 &x, const sjtu::int2048 &y)
+{
+  if (x.sgn != y.sgn) return x.sgn > y.sgn;
+  if (x.len != y.len) return x.len * x.sgn > y.len * y.sgn;
+  for (int i = x.len - 1; i >= 0; --i)
+    if (x.a[i] != y.a[i]) return x.a[i] * x.sgn > y.a[i] * y.sgn;
+  return false;
+}
+
+bool sjtu::operator<=(const sjtu::int2048 &x, const sjtu::int2048 &y)
+{
+  if (x > y) { return false; }
+  else { return true; }
+}
+
+bool sjtu::operator>=(const sjtu::int2048 &x, const sjtu::int2048 &y)
+{
+  if (x < y) { return false; }
+  else { return true; }
+}
+
+sjtu::int2048 sjtu::UnsignedAdd(const sjtu::int2048 &x, const sjtu::int2048 &y)
+{
+  if (x.len < y.len) return UnsignedAdd(y, x);
+  sjtu::int2048 ans;
+  ans.Allocate(x.len + 1);
+  int carry = sjtu::int2048::AddN(ans.a, x.a, y.a, y.len);
+  for (int i = y.len; i < x.len; ++i)
+  {
+    ans.a[i] = x.a[i] + carry;
+    carry = (ans.a[i] == sjtu::int2048::base);
+    if (carry != 0) ans.a[i] = 0;
+  }
+  ans.a[x.len] = carry;
+  ans.len = x.len + carry;
+  return ans;
+}
+
+sjtu::int2048 sjtu::UnsignedMinus(const sjtu::int2048 &x, const sjtu::int2048 &y)
+{
+  sjtu::int2048 ans;
+  ans.Allocate(x.len);
+  int borrow = sjtu::int2048::SubN(ans.a, x.a, y.a, y.len);
+  for (int i = y.len; i < x.len; ++i)
+  {
+    ans.a[i] = x.a[i] - borrow;
+    borrow = (ans.a[i] < 0);
+    if (borrow != 0) ans.a[i] = sjtu::int2048::base - 1;
+  }
+  ans.len = x.len;
+  while (ans.a[ans.len - 1] == 0 && ans.len >= 2) --ans.len;
+  return ans;
+}
+
+void sjtu::int2048::UnsignedAddAssign(const sjtu::int2048 &val)
+{
+  int n = std::max(len, val.len);
+  Grow(n + 1);
+  for (int i = len; i <= n; ++i) a[i] = 0;
+  int carry = AddN(a, a, val.a, val.len);
+  for (int i = val.len; carry != 0; ++i)
+  {
+    ++a[i], carry = 0;
+    if (a[i] == base) a[i] = 0, carry = 1;
+  }
+  len = (a[n] != 0)? n + 1: n;
+}
+
+void sjtu::int2048::UnsignedMinusAssign(const sjtu::int2048 &val)
+{
+  int borrow = SubN(a, a, val.a, val.len);
+  for (int i = val.len; borrow != 0; ++i)
+  {
+    --a[i], borrow = 0;
+    if (a[i] < 0) a[i] = base - 1, borrow = 1;
+  }
+  while (a[len - 1] == 0 && len >= 2) --len;
+}
+
+void sjtu::int2048::UnsignedReverseMinusAssign(const sjtu::int2048 &val)
+{
+  Grow(val.len);
+  int borrow = SubN(a, val.a, a, len);
+  for (int i = len; i < val.len; ++i)
+  {
+    a[i] = val.a[i] - borrow;
+    borrow = (a[i] < 0);
+    if (borrow != 0) a[i] = base - 1;
+  }
+  len = val.len;
+  while (a[len - 1] == 0 && len >= 2) --len;
+}
+
+int sjtu::int2048::UnsignedCompare(const sjtu::int2048 &x, const sjtu::int2048 &y)
+{
+  if (x.len != y.len) return x.len < y.len ? -1 : 1;
+  for (int i = x.len - 1; i >= 0; --i)
+    if (x.a[i] != y.a[i]) return x.a[i] < y.a[i] ? -1 : 1;
+  return 0;
+}
+
+void sjtu::int2048::SignedAddAssign(const sjtu::int2048 &val, int val_sgn)
+{
+  // 同号时绝对值相加; 异号时用绝对值较大者减去较小者, 结果直接写在当前的缓冲区上
+  if (sgn == val_sgn)
+  {
+    UnsignedAddAssign(val);
+    return;
+  }
+  if (UnsignedCompare(*this, val) >= 0)
+  {
+    UnsignedMinusAssign(val);
+  }
+  else
+  {
+    UnsignedReverseMinusAssign(val);
+    sgn = val_sgn;
+  }
+  if (len == 1 && a[0] == 0) sgn = 1;
+}
+
+sjtu::int2048 &sjtu::int2048::add(const sjtu::int2048 &val)
+{
+  SignedAddAssign(val, val.sgn);
+  return *this;
+}
+
+sjtu::int2048 sjtu::add(sjtu::int2048 x, const sjtu::int2048 &y)
+{
+  x.add(y);
+  return x;
+}
+
+sjtu::int2048 &sjtu::int2048::minus(const sjtu::int2048 &val)
+{
+  SignedAddAssign(val, -val.sgn);
+  return *this;
+}
+
+sjtu::int2048 sjtu::minus(sjtu::int2048 x, const sjtu::int2048 &y)
+{
+  return x.minus(y);
+}
+
+sjtu::int2048 &sjtu::int2048::operator+=(const sjtu::int2048 &val)
+{
+  add(val);
+  return *this;
+}
+
+sjtu::int2048 sjtu::operator+(sjtu::int2048 x, const sjtu::int2048 &y)
+{
+  x.add(y);
+  return x;
+}
+
+sjtu::int2048 &sjtu::int2048::operator-=(const sjtu::int2048 &x)
+{
+  minus(x);
+  return *this;
+}
+
+sjtu::int2048 sjtu::operator-(sjtu::int2048 x, const sjtu::int2048 &y)
+{
+  x.minus(y);
+  return x;
+}
+
+int sjtu::int2048::AddN(int *r, const int *x, const int *y, int n)
+{
+  static int (*const kernel)(int *, const int *, const int *, int) =
+      active_kernel_set() == kernel_set::avx512 ? AddNAvx512
+      : active_kernel_set() == kernel_set::avx2 ? AddNAvx2 : AddNScalar;
+  return n >= 32 ? kernel(r, x, y, n) : AddNScalar(r, x, y, n);
+}
+
+int sjtu::int2048::SubN(int *r, const int *x, const int *y, int n)
+{
+  static int (*const kernel)(int *, const int *, const int *, int) =
+      active_kernel_set() == kernel_set::avx512 ? SubNAvx512
+      : active_kernel_set() == kernel_set::avx2 ? SubNAvx2 : SubNScalar;
+  return n >= 32 ? kernel(r, x, y, n) : SubNScalar(r, x, y, n);
+}
+
+int sjtu::int2048::AddNScalar(int *r, const int *x, const int *y, int n)
+{
+  // 和不超过2 * base - 1 < 2^31, 用比较代替除法求进位
+  int carry = 0;
+  for (int i = 0; i < n; ++i)
+  {
+    r[i] = x[i] + y[i] + carry;
+    carry = (r[i] >= base);
+    r[i] -= carry * base;
+  }
+  return carry;
+}
+
+int sjtu::int2048::SubNScalar(int *r, const int *x, const int *y, int n)
+{
+  int borrow = 0;
+  for (int i = 0; i < n; ++i)
+  {
+    r[i] = x[i] - y[i] - borrow;
+    borrow = (r[i] < 0);
+    r[i] += borrow * base;
+  }
+  return borrow;
+}
+
+int sjtu::int2048::AddNFinish(int *r, const int *x, const int *y, int n, int m,
+                              int carry, bool fix)
+{
+  // 向量内核得到的每一位在[0, base]中, 只有原本为base - 1且收到进位的位会等于base
+  // r[m - 1]本身产生进位时结果不超过base - 2, 因此修正与carry不会同时产生进位
+  if (fix)
+  {
+    for (int i = 0; i < m - 1; ++i)
+      if (r[i] == base) r[i] = 0, ++r[i + 1];
+    if (r[m - 1] == base) r[m - 1] = 0, carry = 1;
+  }
+  for (int i = m; i < n; ++i)
+  {
+    r[i] = x[i] + y[i] + carry;
+    carry = (r[i] >= base);
+    r[i] -= carry * base;
+  }
+  return carry;
+}
+
+int sjtu::int2048::SubNFinish(int *r, const int *x, const int *y, int n, int m,
+                              int borrow, bool fix)
+{
+  // 与AddNFinish对称, 每一位在[-1, base - 1]中, 等于-1的位向高位借1
+  if (fix)
+  {
+    for (int i = 0; i < m - 1; ++i)
+      if (r[i] < 0) r[i] = base - 1, --r[i + 1];
+    if (r[m - 1] < 0) r[m - 1] = base - 1, borrow = 1;
+  }
+  for (int i = m; i < n; ++i)
+  {
+    r[i] = x[i] - y[i] - borrow;
+    borrow = (r[i] < 0);
+    r[i] += borrow * base;
+  }
+  return borrow;
+}
+
+#ifdef INT2048_X86_SIMD
+__attribute__((target("avx2")))
+int sjtu::int2048::AddNAvx2(int *r, const int *x, const int *y, int n)
+{
+  // 每个lane先独立求和并减去base得到进位c, 再把c整体右移一个lane作为下一位的进位输入
+  const __m256i vbase = _mm256_set1_epi32(base), vmax = _mm256_set1_epi32(base - 1);
+  const __m256i rot = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+  __m256i prev = _mm256_setzero_si256(), overflow = _mm256_setzero_si256();
+  int m = n & ~7;
+  for (int i = 0; i < m; i += 8)
+  {
+    __m256i cur = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i)),
+                                   _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i)));
+    __m256i c = _mm256_cmpgt_epi32(cur, vmax); // 有进位的lane为-1
+    cur = _mm256_sub_epi32(cur, _mm256_and_si256(c, vbase));
+    // c循环右移后第0个lane是本组最高位的进位, 替换为上一组最高位的进位
+    __m256i shifted = _mm256_permutevar8x32_epi32(c, rot);
+    cur = _mm256_sub_epi32(cur, _mm256_blend_epi32(shifted, prev, 1));
+    prev = shifted;
+    overflow = _mm256_or_si256(overflow, _mm256_cmpeq_epi32(cur, vbase));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), cur);
+  }
+  return AddNFinish(r, x, y, n, m, -_mm256_extract_epi32(prev, 0),
+                    !_mm256_testz_si256(overflow, overflow));
+}
+
+__attribute__((target("avx2")))
+int sjtu::int2048::SubNAvx2(int *r, const int *x, const int *y, int n)
+{
+  const __m256i vbase = _mm256_set1_epi32(base), zero = _mm256_setzero_si256();
+  const __m256i neg = _mm256_set1_epi32(-1);
+  const __m256i rot = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+  __m256i prev = zero, overflow = zero;
+  int m = n & ~7;
+  for (int i = 0; i < m; i += 8)
+  {
+    __m256i cur = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i)),
+                                   _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i)));
+    __m256i b = _mm256_cmpgt_epi32(zero, cur); // 有借位的lane为-1
+    cur = _mm256_add_epi32(cur, _mm256_and_si256(b, vbase));
+    __m256i shifted = _mm256_permutevar8x32_epi32(b, rot);
+    cur = _mm256_add_epi32(cur, _mm256_blend_epi32(shifted, prev, 1));
+    prev = shifted;
+    overflow = _mm256_or_si256(overflow, _mm256_cmpeq_epi32(cur, neg));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), cur);
+  }
+  return SubNFinish(r, x, y, n, m, -_mm256_extract_epi32(prev, 0),
+                    !_mm256_testz_si256(overflow, overflow));
+}
+
+__attribute__((target("avx512f")))
+int sjtu::int2048::AddNAvx512(int *r, const int *x, const int *y, int n)
+{
+  // 进位以掩码表示, 左移一位即为下一位的进位输入, 不需要跨lane的置换
+  const __m512i vbase = _mm512_set1_epi32(base), vmax = _mm512_set1_epi32(base - 1);
+  const __m512i one = _mm512_set1_epi32(1);
+  unsigned carry = 0, overflow = 0;
+  int m = n & ~15;
+  for (int i = 0; i < m; i += 16)
+  {
+    __m512i cur = _mm512_add_epi32(_mm512_loadu_si512(x + i), _mm512_loadu_si512(y + i));
+    __mmask16 c = _mm512_cmpgt_epi32_mask(cur, vmax);
+    cur = _mm512_mask_sub_epi32(cur, c, cur, vbase);
+    cur = _mm512_mask_add_epi32(cur, static_cast<__mmask16>((c << 1) | carry), cur, one);
+    carry = c >> 15;
+    overflow |= _mm512_cmpeq_epi32_mask(cur, vbase);
+    _mm512_storeu_si512(r + i, cur);
+  }
+  return AddNFinish(r, x, y, n, m, static_cast<int>(carry), overflow != 0);
+}
+
+__attribute__((target("avx512f")))
+int sjtu::int2048::SubNAvx512(int *r, const int *x, const int *y, int n)
+{
+  const __m512i vbase = _mm512_set1_epi32(base), zero = _mm512_setzero_si512();
+  const __m512i one = _mm512_set1_epi32(1);
+  unsigned borrow = 0, overflow = 0;
+  int m = n & ~15;
+  for (int i = 0; i < m; i += 16)
+  {
+    __m512i cur = _mm512_sub_epi32(_mm512_loadu_si512(x + i), _mm512_loadu_si512(y + i));
+    __mmask16 b = _mm512_cmplt_epi32_mask(cur, zero);
+    cur = _mm512_mask_add_epi32(cur, b, cur, vbase);
+    cur = _mm512_mask_sub_epi32(cur, static_cast<__mmask16>((b << 1) | borrow), cur, one);
+    borrow = b >> 15;
+    overflow |= _mm512_cmplt_epi32_mask(cur, zero);
+    _mm512_storeu_si512(r + i, cur);
+  }
+  return SubNFinish(r, x, y, n, m, static_cast<int>(borrow), overflow != 0);
+}
+#else
+int sjtu::int2048::AddNAvx2(int *r, const int *x, const int *y, int n)
+{
+  return AddNScalar(r, x, y, n);
+}
+
+int sjtu::int2048::SubNAvx2(int *r, const int *x, const int *y, int n)
+{
+  return SubNScalar(r, x, y, n);
+}
+
+int sjtu::int2048::AddNAvx512(int *r, const int *x, const int *y, int n)
+{
+  return AddNScalar(r, x, y, n);
+}
+
+int sjtu::int2048::SubNAvx512(int *r, const int *x, const int *y, int n)
+{
+  return SubNScalar(r, x, y, n);
+}
+#endif
+
+void sjtu::int2048::AddTo(int *r, const int *x, int n)
+{
+  int carry = AddN(r, r, x, n);
+  for (int i = n; carry != 0; ++i)
+  {
+    ++r[i], carry = 0;
+    if (r[i] == base) r[i] = 0, carry = 1;
+  }
+}
+
+void sjtu::int2048::MinusFrom(int *r, const int *x, int n)
+{
+  int borrow = SubN(r, r, x, n);
+  for (int i = n; borrow != 0; ++i)
+  {
+    --r[i], borrow = 0;
+    if (r[i] < 0) r[i] = base - 1, borrow = 1;
+  }
+}
+
+void sjtu::int2048::FoldCarry(unsigned long long *sum, int n)
+{
+  unsigned long long carry = 0;
+  for (int i = 0; i < n; ++i)
+  {
+    carry += sum[i];
+    sum[i] = carry % base;
+    carry /= base;
+  }
+  sum[n] += carry;
+}
+
+void sjtu::int2048::SchoolMultiply(const int *a, int na, const int *b, int nb,
+                                   int *r)
+{
+  // 先不进位地累加每一位上的乘积, 每school_fold行进位一次, 最后统一进位
+  // 每一位在两次进位之间至多累加school_fold个乘积, 不会超过unsigned long long
+  unsigned long long buf[school_buf_len];
+  unsigned long long *sum = (na + nb <= school_buf_len) ? buf : new unsigned long long [na + nb];
+  for (int i = 0; i < na + nb; ++i) sum[i] = 0;
+  for (int i = 0; i < na; ++i)
+  {
+    unsigned long long cur = a[i];
+    for (int j = 0; j < nb; ++j) sum[i + j] += cur * b[j];
+    if ((i + 1) % school_fold == 0 && i + 1 < na) FoldCarry(sum + i + 1 - school_fold, school_fold + nb - 1);
+  }
+  unsigned long long carry = 0;
+  for (int i = 0; i < na + nb; ++i)
+  {
+    carry += sum[i];
+    r[i] = static_cast<int>(carry % base);
+    carry /= base;
+  }
+  if (sum != buf) delete [] sum;
+}
+
+void sjtu::int2048::KaratsubaMultiply(const int *a, const int *b, int n,
+                                      int *r, int *tmp)
+{
+  // 递归的长度为n / 2 + 1, n < 4时无法继续缩小
+  if (n < INT2048_KARATSUBA_THRESHOLD || n < 4)
+  {
+    SchoolMultiply(a, n, b, n, r);
+    return;
+  }
+  // a = a1 * base^m + a0, b = b1 * base^m + b0
+  int m = n >> 1, h = n - m;
+  KaratsubaMultiply(a, b, m, r, tmp);
+  KaratsubaMultiply(a + m, b + m, h, r + 2 * m, tmp);
+  int *sa = tmp, *sb = tmp + h + 1, *mid = tmp + 2 * h + 2;
+  for (int i = 0; i < h; ++i) sa[i] = a[m + i], sb[i] = b[m + i];
+  sa[h] = sb[h] = 0;
+  AddTo(sa, a, m), AddTo(sb, b, m);
+  // mid = (a0 + a1) * (b0 + b1) - a0 * b0 - a1 * b1 = a0 * b1 + a1 * b0
+  KaratsubaMultiply(sa, sb, h + 1, mid, mid + 2 * h + 2);
+  MinusFrom(mid, r, 2 * m);
+  MinusFrom(mid, r + 2 * m, 2 * h);
+  // mid < 2 * base^(n + 1), 因此只需要加上它的低n + 1位
+  AddTo(r + m, mid, n + 1);
+}
+
+void sjtu::int2048::SchoolSquare(const int *a, int n, int *r)
+{
+  // sum[k] = 2 * sum(a[i] * a[j], i < j, i + j = k) + a[k / 2]^2
+  unsigned long long buf[school_buf_len];
+  unsigned long long *sum = (2 * n <= school_buf_len) ? buf : new unsigned long long [2 * n];
+  for (int i = 0; i < 2 * n; ++i) sum[i] = 0;
+  for (int i = 0; i < n; ++i)
+  {
+    unsigned long long cur = a[i];
+    for (int j = i + 1; j < n; ++j) sum[i + j] += cur * a[j];
+    if ((i + 1) % school_fold == 0) FoldCarry(sum + i + 1 - school_fold, school_fold + n - 1);
+  }
+  // 交叉项乘2之前先完全进位, 保证乘2和加上平方项后不会溢出
+  FoldCarry(sum, 2 * n - 1);
+  for (int i = 0; i < 2 * n; ++i) sum[i] *= 2;
+  for (int i = 0; i < n; ++i) sum[2 * i] += 1ull * a[i] * a[i];
+  unsigned long long carry = 0;
+  for (int i = 0; i < 2 * n; ++i)
+  {
+    carry += sum[i];
+    r[i] = static_cast<int>(carry % base);
+    carry /= base;
+  }
+  if (sum != buf) delete [] sum;
+}
+
+void sjtu::int2048::KaratsubaSquare(const int *a, int n, int *r, int *tmp)
+{
+  if (n < INT2048_KARATSUBA_THRESHOLD || n < 4)
+  {
+    SchoolSquare(a, n, r);
+    return;
+  }
+  int m = n >> 1, h = n - m;
+  KaratsubaSquare(a, m, r, tmp);
+  KaratsubaSquare(a + m, h, r + 2 * m, tmp);
+  int *sa = tmp, *mid = tmp + h + 1;
+  for (int i = 0; i < h; ++i) sa[i] = a[m + i];
+  sa[h] = 0;
+  AddTo(sa, a, m);
+  // mid = (a0 + a1)^2 - a0^2 - a1^2 = 2 * a0 * a1
+  KaratsubaSquare(sa, h + 1, mid, mid + 2 * h + 2);
+  MinusFrom(mid, r, 2 * m);
+  MinusFrom(mid, r + 2 * m, 2 * h);
+  AddTo(r + m, mid, n + 1);
+}
+
+sjtu::int2048 sjtu::int2048::Slice(int l, int r) const
+{
+  sjtu::int2048 ret;
+  if (r > len) r = len;
+  if (l >= r) return ret;
+  ret.len = r - l;
+  ret.Allocate(ret.len);
+  for (int i = l; i < r; ++i) ret.a[i - l] = a[i];
+  while (ret.a[ret.len - 1] == 0 && ret.len >= 2) --ret.len;
+  return ret;
+}
+
+sjtu::int2048 &sjtu::int2048::DivideExactSmall(int val)
+{
+  DivideSmall(val);
+  return *this;
 }
 
-sjtu::int2048 sjtu::add(sjtu::int2048 x, const sjtu::int2048 &y)
+int sjtu::int2048::DivideSmall(int val)
 {
-  x.add(y);
-  return x;
+  long long rem = 0;
+  for (int i = len - 1; i >= 0; --i)
+  {
+    rem = rem * base + a[i];
+    a[i] = static_cast<int>(rem / val);
+    rem %= val;
+  }
+  while (a[len - 1] == 0 && len >= 2) --len;
+  if (len == 1 && a[0] == 0) sgn = 1;
+  return static_cast<int>(rem);
 }
 
-sjtu::int2048 &sjtu::int2048::minus(const sjtu::int2048 &val)
+sjtu::int2048 sjtu::Toom3Multiply(const sjtu::int2048 &x, const sjtu::int2048 &y)
 {
-  add(-val);
-  return *this;
+  // 将x, y各分为3段, 在0, 1, -1, -2, inf处求值, 按照Bodrato的顺序插值
+  int k = (std::max(x.len, y.len) + 2) / 3;
+  sjtu::int2048 x0 = x.Slice(0, k), x1 = x.Slice(k, 2 * k), x2 = x.Slice(2 * k, 3 * k);
+  sjtu::int2048 y0 = y.Slice(0, k), y1 = y.Slice(k, 2 * k), y2 = y.Slice(2 * k, 3 * k);
+  sjtu::int2048 px = x0 + x2, p1 = px + x1, pm1 = px - x1;
+  sjtu::int2048 pm2 = (pm1 + x2) * 2 - x0;
+  sjtu::int2048 r0, r1, rm1, rm2, rinf;
+  if (&x == &y)
+  {
+    // 平方时五个乘积都是平方
+    r0 = square(x0), r1 = square(p1), rm1 = square(pm1);
+    rm2 = square(pm2), rinf = square(x2);
+  }
+  else
+  {
+    sjtu::int2048 py = y0 + y2, q1 = py + y1, qm1 = py - y1;
+    sjtu::int2048 qm2 = (qm1 + y2) * 2 - y0;
+    r0 = x0 * y0, r1 = p1 * q1, rm1 = pm1 * qm1;
+    rm2 = pm2 * qm2, rinf = x2 * y2;
+  }
+  sjtu::int2048 r3 = (rm2 - r1).DivideExactSmall(3);
+  r1 = (r1 - rm1).DivideExactSmall(2);
+  sjtu::int2048 r2 = rm1 - r0;
+  r3 = (r2 - r3).DivideExactSmall(2) + rinf * 2;
+  r2 += r1 - rinf;
+  r1 -= r3;
+  sjtu::int2048 ret = r0;
+  ret += r1 << k;
+  ret += r2 << (2 * k);
+  ret += r3 << (3 * k);
+  ret += rinf << (4 * k);
+  return ret;
 }
 
-sjtu::int2048 sjtu::minus(sjtu::int2048 x, const sjtu::int2048 &y)
+sjtu::int2048 sjtu::UnsignedMultiply(const sjtu::int2048 &x, const sjtu::int2048 &y)
 {
-  return x.minus(y);
+  const sjtu::int2048 &u = (x.len >= y.len) ? x : y;
+  const sjtu::int2048 &v = (x.len >= y.len) ? y : x;
+  if (v.len >= INT2048_NTT_THRESHOLD)
+  {
+    // 乘积超过变换长度上限时也交给UnbalancedMultiply分段
+    if (u.len >= 2 * v.len || u.len + v.len > sjtu::polynomial::max_len) return UnbalancedMultiply(u, v);
+    sjtu::polynomial px(u), py(v);
+    return px.Multiply(py).ToInteger();
+  }
+  // Toom-3的分段长度需要严格小于原长度, 否则会无限递归
+  if (v.len >= INT2048_TOOM3_THRESHOLD && v.len >= 16 && u.len < 2 * v.len)
+  {
+    sjtu::int2048 ret = Toom3Multiply(u, v);
+    ret.sgn = 1;
+    return ret;
+  }
+  sjtu::int2048 ret;
+  ret.len = u.len + v.len;
+  ret.Allocate(ret.len);
+  if (v.len < INT2048_KARATSUBA_THRESHOLD)
+  {
+    sjtu::int2048::SchoolMultiply(u.a, u.len, v.a, v.len, ret.a);
+  }
+  else if (v.len < INT2048_TOOM3_THRESHOLD || v.len < 16)
+  {
+    // 将较长的乘数按照v.len分段, 每段与v做Karatsuba乘法后累加
+    int n = v.len;
+    auto *seg = new int [n];
+    auto *prod = new int [2 * n];
+    auto *tmp = new int [4 * n + 512];
+    for (int i = 0; i < ret.len; ++i) ret.a[i] = 0;
+    for (int i = 0; i < u.len; i += n)
+    {
+      int cnt = std::min(n, u.len - i);
+      for (int j = 0; j < n; ++j) seg[j] = (j < cnt) ? u.a[i + j] : 0;
+      sjtu::int2048::KaratsubaMultiply(seg, v.a, n, prod, tmp);
+      sjtu::int2048::AddTo(ret.a + i, prod, cnt + n);
+    }
+    delete [] seg;
+    delete [] prod;
+    delete [] tmp;
+  }
+  else
+  {
+    // 较长的乘数按照v.len分段, 每段与v做Toom-3乘法后累加
+    for (int i = 0; i < ret.len; ++i) ret.a[i] = 0;
+    for (int i = 0; i < u.len; i += v.len)
+    {
+      sjtu::int2048 prod = Toom3Multiply(u.Slice(i, i + v.len), v);
+      sjtu::int2048::AddTo(ret.a + i, prod.a, prod.len);
+    }
+  }
+  while (ret.a[ret.len - 1] == 0 && ret.len >= 2) --ret.len;
+  return ret;
 }
 
-sjtu::int2048 &sjtu::int2048::operator+=(const sjtu::int2048 &val)
+sjtu::int2048 sjtu::UnbalancedMultiply(const sjtu::int2048 &x, const sjtu::int2048 &y)
 {
-  add(val);
-  return *this;
+  int half_len = sjtu::polynomial::max_len / 2;
+  sjtu::int2048 ret;
+  ret.len = x.len + y.len;
+  ret.Allocate(ret.len);
+  for (int i = 0; i < ret.len; ++i) ret.a[i] = 0;
+  if (y.len > half_len)
+  {
+    // 每段y与x相乘时变换长度恰好为上限, x.len >= y.len保证x不短于每一段
+    for (int i = 0; i < y.len; i += half_len)
+    {
+      sjtu::int2048 prod = UnbalancedMultiply(x, y.Slice(i, std::min(i + half_len, y.len)));
+      sjtu::int2048::AddTo(ret.a + i, prod.a, prod.len);
+    }
+    while (ret.a[ret.len - 1] == 0 && ret.len >= 2) --ret.len;
+    return ret;
+  }
+  // 变换长度取不小于2 * y.len的2的幂, 每段长度取变换长度能容纳的最大值
+  int ntt_len = 1;
+  while (ntt_len < 2 * y.len) ntt_len *= 2;
+  int seg_len = ntt_len - y.len + 1;
+  sjtu::polynomial py(y);
+  py.Prepare(ntt_len);
+  for (int i = 0; i < x.len; i += seg_len)
+  {
+    sjtu::polynomial px(x.a + i, std::min(seg_len, x.len - i));
+    sjtu::int2048 prod = px.MultiplyPrepared(py).ToInteger();
+    sjtu::int2048::AddTo(ret.a + i, prod.a, prod.len);
+  }
+  while (ret.a[ret.len - 1] == 0 && ret.len >= 2) --ret.len;
+  return ret;
 }
 
-sjtu::int2048 sjtu::operator+(sjtu::int2048 x, const sjtu::int2048 &y)
+sjtu::int2048 sjtu::UnsignedSquare(const sjtu::int2048 &x)
 {
-  x.add(y);
-  return x;
+  if (x.len >= INT2048_NTT_THRESHOLD)
+  {
+    // 平方超过变换长度上限时分段计算, 此时已不在意少做一次正变换
+    if (2 * x.len > sjtu::polynomial::max_len) return UnbalancedMultiply(x, x);
+    sjtu::polynomial px(x);
+    return px.Square().ToInteger();
+  }
+  if (x.len >= INT2048_TOOM3_THRESHOLD && x.len >= 16)
+  {
+    sjtu::int2048 ret = Toom3Multiply(x, x);
+    ret.sgn = 1;
+    return ret;
+  }
+  sjtu::int2048 ret;
+  ret.len = 2 * x.len;
+  ret.Allocate(ret.len);
+  if (x.len < INT2048_KARATSUBA_THRESHOLD)
+  {
+    sjtu::int2048::SchoolSquare(x.a, x.len, ret.a);
+  }
+  else
+  {
+    auto *tmp = new int [4 * x.len + 512];
+    sjtu::int2048::KaratsubaSquare(x.a, x.len, ret.a, tmp);
+    delete [] tmp;
+  }
+  while (ret.a[ret.len - 1] == 0 && ret.len >= 2) --ret.len;
+  return ret;
 }
 
-sjtu::int2048 &sjtu::int2048::operator-=(const sjtu::int2048 &x)
+sjtu::int2048 &sjtu::int2048::square()
 {
-  minus(x);
+  *this = UnsignedSquare(*this);
+  sgn = 1;
   return *this;
 }
 
-sjtu::int2048 sjtu::operator-(sjtu::int2048 x, const sjtu::int2048 &y)
+sjtu::int2048 sjtu::square(sjtu::int2048 x)
 {
-  x.minus(y);
+  x.square();
   return x;
 }
 
 sjtu::int2048 &sjtu::int2048::operator*=(const sjtu::int2048 &val)
 {
-  sjtu::polynomial x(*this), y(val);
+  if (this == &val) return square();
   int sgn_tmp = sgn * val.sgn;
-  *this = x.Multiply(y).ToInteger();
+  *this = UnsignedMultiply(*this, val);
   sgn = sgn_tmp;
   if (len == 1 && a[0] == 0) sgn = 1;
   return *this;
@@ -607,95 +1936,623 @@ sjtu::int2048 sjtu::operator*(sjtu::int2048 x, const sjtu::int2048 &y)
 
 sjtu::int2048 sjtu::operator*(sjtu::int2048 x, long long y)
 {
-  if (y >= static_cast<long long>(1e12)) return x * int2048(y);
+  // 保证每一位的乘积不超过long long
+  if (y >= sjtu::int2048::base || y <= -sjtu::int2048::base) return x * int2048(y);
+  // 乘0时逐位相乘不会缩短长度, 直接返回0
+  if (y == 0) return sjtu::int2048(0);
   if (y < 0)
   {
     x.sgn *= -1;
     y = std::abs(y);
   }
-  auto *tmp = new long long [x.len + 20];
-  for (int i = 0; i < x.len; ++i) tmp[i] = 1ll * x.a[i] * y;
-  for (int i = 1; i < x.len; ++i)
+  // 原地逐位相乘并进位, 商和余数由同一次除以常数(编译为乘法)得到, 进位小于base, 至多多出一位
+  x.Grow(x.len + 1);
+  long long carry = 0;
+  for (int i = 0; i < x.len; ++i)
+  {
+    long long cur = 1ll * x.a[i] * y + carry;
+    carry = cur / sjtu::int2048::base;
+    x.a[i] = static_cast<int>(cur - carry * sjtu::int2048::base);
+  }
+  if (carry != 0) x.a[x.len++] = static_cast<int>(carry);
+  if (x.len == 1 && x.a[0] == 0) x.sgn = 1;
+  return x;
+}
+
+sjtu::int2048 sjtu::Adjust(const int2048 &dividend, const int2048 &divisor,
+                           int2048 &quotient)
+{
+  // 商的误差只有常数个单位, 故|余数| < base^(n + 1), 只需在模base^(n + 2) - 1下计算
+  int n = divisor.len + 2;
+  int2048 product = WrapMultiply(divisor, quotient, n);
+  int2048 remainder(dividend);
+  remainder.ModWrap(n);
+  remainder -= product;
+  if (remainder < 0) remainder += (int2048(1) << n) - 1;
+  if (!remainder.Unwrap(n)) remainder = dividend - divisor * quotient;
+  while (remainder < 0)
   {
-    tmp[i] += tmp[i - 1] / sjtu::int2048::base;
-    tmp[i - 1] %= sjtu::int2048::base;
+    quotient -= 1;
+    remainder += divisor;
   }
-  while (tmp[x.len - 1] >= sjtu::int2048::base)
+  while (remainder >= divisor)
   {
-    tmp[x.len] = tmp[x.len - 1] / sjtu::int2048::base;
-    tmp[x.len - 1] %= sjtu::int2048::base;
-    ++x.len;
+    quotient += 1;
+    remainder -= divisor;
   }
-  for (int i = 0; i < x.len; ++i) x.a[i] = static_cast<int>(tmp[i]);
-  delete [] tmp;
-  return x;
+  return remainder;
+}
+
+sjtu::int2048 &sjtu::int2048::ModWrap(int n)
+{
+  // base^n ≡ 1, 因此把高于n的部分加回低位即可
+  while (len > n)
+  {
+    sjtu::int2048 high = Slice(n, len);
+    len = n;
+    while (a[len - 1] == 0 && len >= 2) --len;
+    UnsignedAddAssign(high);
+  }
+  if (len == n)
+  {
+    bool all_max = true;
+    for (int i = 0; i < n && all_max; ++i) all_max = (a[i] == base - 1);
+    if (all_max) len = 1, a[0] = 0;
+  }
+  return *this;
 }
 
-void sjtu::Adjust(const int2048 &dividend, const int2048 &divisor,
-                  int2048 &quotient, long long max_delta)
+bool sjtu::int2048::Unwrap(int n)
 {
-  int2048 remainder = dividend - divisor * quotient;
-  long long left = -max_delta - 1, right = max_delta + 1;
-  while (left + 1 < right)
+  sgn = 1;
+  if (len < n) return true;
+  // 当前数不小于base^(n - 1), 原数只能是负数, 其绝对值为base^n - 1 - 当前数
+  for (int i = 0; i < n; ++i) a[i] = base - 1 - a[i];
+  while (a[len - 1] == 0 && len >= 2) --len;
+  if (len != 1 || a[0] != 0) sgn = -1;
+  return len < n;
+}
+
+sjtu::int2048 sjtu::WrapMultiply(const sjtu::int2048 &x, const sjtu::int2048 &y, int &n)
+{
+  if (std::min(x.len, y.len) < INT2048_NTT_THRESHOLD)
   {
-    long long mid = (left + right) / 2;
-    if (remainder < divisor * mid) { right = mid; }
-    else { left = mid; }
+    sjtu::int2048 ret = UnsignedMultiply(x, y);
+    return ret.ModWrap(n);
   }
-  quotient += int2048(left);
-  if (dividend - divisor * (quotient + 1) >= 0) quotient += int2048(1);
+  // 循环卷积的长度只需要覆盖n, 而不必覆盖整个乘积; 超过变换长度上限时退回完整的乘积
+  int ntt_len = 1;
+  while (ntt_len < n) ntt_len *= 2;
+  if (ntt_len > sjtu::polynomial::max_len)
+  {
+    sjtu::int2048 ret = UnsignedMultiply(x, y);
+    return ret.ModWrap(n);
+  }
+  n = ntt_len;
+  sjtu::int2048 u(x), v(y);
+  u.ModWrap(n), v.ModWrap(n);
+  sjtu::polynomial pu(u), pv(v);
+  sjtu::int2048 ret = pu.MultiplyCyclic(pv, n).ToInteger();
+  return ret.ModWrap(n);
 }
 
 sjtu::int2048 sjtu::GetInv(const sjtu::int2048 &val, int len)
 {
   if (len <= 2)
   {
-    long long dividend = (len == 1)? 1e8:1e16;
-    long long divisor = val.a[val.len - 1];
+    // base^4 / base的结果可能超过long long, 因此用__int128计算后逐位写入
+    unsigned __int128 dividend = 1;
+    for (int i = 0; i < 2 * len; ++i) dividend *= sjtu::int2048::base;
+    unsigned long long divisor = val.a[val.len - 1];
     if (len == 2)
     {
       divisor = divisor * sjtu::int2048::base + val.a[val.len - 2];
     }
-    return dividend / divisor;
+    unsigned __int128 quotient = dividend / divisor;
+    sjtu::int2048 ret;
+    ret.Allocate(4);
+    ret.len = 0;
+    do
+    {
+      ret.a[ret.len++] = static_cast<int>(quotient % sjtu::int2048::base);
+      quotient /= sjtu::int2048::base;
+    } while (quotient != 0);
+    return ret;
   }
-  int k = (len + 2) >> 1;
-  sjtu::int2048 ans= GetInv(val, k);
-  ans = ((2 * ans) << (len - k)) -
-        (((val >> (val.len - len)) * ans * ans) >> (2 * k));
-  return ans;
+  // 先求出最高k个block的逆X_k, 再迭代一次使精度翻倍:
+  // X = X_k * base^(len - k) + X_k * E / base^(2k), 其中E = base^(len + k) - V * X_k
+  // 由于X_k的相对误差约为base^(-k), |E| < base^(len + 2), 所以V * X_k只需要模base^(len + 3) - 1
+  // 2k比len多出几位, 使误差在base较小时也不会随递归层数累积
+  int k = std::min(len - 1, len / 2 + 2);
+  sjtu::int2048 inv = GetInv(val, k);
+  sjtu::int2048 v = val.Slice(val.len - len, val.len);
+  int n = len + 3;
+  sjtu::int2048 err = WrapMultiply(v, inv, n);
+  err = (sjtu::int2048(1) << ((len + k) % n)) - err;
+  if (err.sgn == -1) err += (sjtu::int2048(1) << n) - 1;
+  if (!err.Unwrap(n)) err = (sjtu::int2048(1) << (len + k)) - v * inv;
+  // E的低k - 2位对结果的影响不超过1, 直接舍去
+  int drop = k - 2;
+  int err_sgn = err.sgn;
+  err.sgn = 1;
+  err >>= drop;
+  sjtu::int2048 delta = (inv * err) >> (2 * k - drop);
+  inv <<= (len - k);
+  if (err_sgn == 1) { inv += delta; }
+  else { inv -= delta; }
+  return inv;
 }
 
-sjtu::int2048 &sjtu::int2048::UnsignedDivide(const sjtu::int2048 &val)
+unsigned long long sjtu::int2048::DivideSmall(const sjtu::reciprocal &val)
+{
+  unsigned long long rem = 0;
+  for (int i = len - 1; i >= 0; --i)
+  {
+    // rem < divisor, 故rem * base + a[i]的高64位小于divisor
+    unsigned __int128 cur = static_cast<unsigned __int128>(rem) * base + a[i];
+    unsigned long long q = val.DivRem(static_cast<unsigned long long>(cur >> 64),
+                                      static_cast<unsigned long long>(cur), rem);
+    a[i] = static_cast<int>(q);
+  }
+  while (a[len - 1] == 0 && len >= 2) --len;
+  if (len == 1 && a[0] == 0) sgn = 1;
+  return rem;
+}
+
+sjtu::int2048 sjtu::int2048::SchoolDivide(const sjtu::int2048 &val)
+{
+  int n = val.len, m = len - n;
+  sjtu::int2048 quotient;
+  if (m < 0) return quotient;
+  Reserve(len + 1);
+  a[len] = 0;
+  quotient.Allocate(m + 1);
+  quotient.len = m + 1;
+  const long long top = val.a[n - 1], second = val.a[n - 2];
+  for (int j = m; j >= 0; --j)
+  {
+    int *r = a + j;
+    // 用最高两位估计商, 再用除数的次高位修正, 修正后的估计值至多偏大1
+    long long num = 1ll * r[n] * base + r[n - 1];
+    long long q = num / top, rem = num - q * top;
+    if (q >= base) q = base - 1, rem = num - q * top;
+    while (rem < base && q * second > rem * base + r[n - 2]) --q, rem += top;
+    long long carry = 0, borrow = 0;
+    for (int i = 0; i < n; ++i)
+    {
+      long long prod = q * val.a[i] + carry;
+      carry = prod / base;
+      long long cur = r[i] - (prod - carry * base) - borrow;
+      borrow = (cur < 0);
+      r[i] = static_cast<int>(cur + borrow * base);
+    }
+    long long high = r[n] - carry - borrow;
+    if (high < 0)
+    {
+      // 估计值偏大1, 加回一倍除数
+      --q;
+      carry = 0;
+      for (int i = 0; i < n; ++i)
+      {
+        long long cur = r[i] + val.a[i] + carry;
+        carry = (cur >= base);
+        r[i] = static_cast<int>(cur - carry * base);
+      }
+      high += carry;
+    }
+    r[n] = static_cast<int>(high);
+    quotient.a[j] = static_cast<int>(q);
+  }
+  len = n;
+  while (a[len - 1] == 0 && len >= 2) --len;
+  while (quotient.a[quotient.len - 1] == 0 && quotient.len >= 2) --quotient.len;
+  return quotient;
+}
+
+sjtu::int2048 sjtu::Divide2n1n(sjtu::int2048 &x, const sjtu::int2048 &y)
+{
+  int n = y.len;
+  if (n < INT2048_BZ_THRESHOLD || x.len - n < INT2048_BZ_THRESHOLD) return x.SchoolDivide(y);
+  if (n & 1)
+  {
+    // 长度为奇数时给两者补一个0 block
+    x <<= 1;
+    sjtu::int2048 quotient = Divide2n1n(x, y << 1);
+    x >>= 1;
+    return quotient;
+  }
+  int half = n / 2;
+  sjtu::int2048 high = y.Slice(half, n), low = y.Slice(0, half);
+  sjtu::int2048 rest = x.Slice(0, half);
+  x >>= half;
+  sjtu::int2048 quotient = Divide3n2n(x, y, high, low);
+  x <<= half;
+  x += rest;
+  sjtu::int2048 quotient_low = Divide3n2n(x, y, high, low);
+  quotient <<= half;
+  quotient += quotient_low;
+  return quotient;
+}
+
+sjtu::int2048 sjtu::Divide3n2n(sjtu::int2048 &x, const sjtu::int2048 &y,
+                               const sjtu::int2048 &high, const sjtu::int2048 &low)
+{
+  int half = y.len - high.len;
+  sjtu::int2048 rest = x.Slice(0, half);
+  x >>= half;
+  sjtu::int2048 quotient;
+  if (x.Slice(half, x.len) == high)
+  {
+    // 此时商的估计值为base^half - 1
+    quotient = (sjtu::int2048(1) << half) - 1;
+    x -= high << half;
+    x += high;
+  }
+  else
+  {
+    quotient = Divide2n1n(x, high);
+  }
+  x <<= half;
+  x += rest;
+  x -= quotient * low;
+  // 估计值至多偏大2
+  while (x < 0)
+  {
+    quotient -= 1;
+    x += y;
+  }
+  return quotient;
+}
+
+sjtu::int2048 sjtu::int2048::RecursiveDivide(const sjtu::int2048 &val)
+{
+  // 从高到低每次取n个block接在余数后面, 余数小于除数保证了每段商都不超过n个block
+  int n = val.len, blocks = (len + n - 1) / n;
+  sjtu::int2048 quotient, rem;
+  quotient.Allocate(blocks * n);
+  quotient.len = blocks * n;
+  for (int i = 0; i < quotient.len; ++i) quotient.a[i] = 0;
+  for (int i = blocks - 1; i >= 0; --i)
+  {
+    rem <<= n;
+    rem += Slice(i * n, (i + 1) * n);
+    sjtu::int2048 part = Divide2n1n(rem, val);
+    for (int j = 0; j < part.len; ++j) quotient.a[i * n + j] = part.a[j];
+  }
+  *this = std::move(rem);
+  while (quotient.a[quotient.len - 1] == 0 && quotient.len >= 2) --quotient.len;
+  return quotient;
+}
+
+sjtu::int2048 sjtu::int2048::NewtonDivide(const sjtu::int2048 &val)
+{
+  // 商有qlen位, 只需要除数的最高k = qlen + 2位就能把商确定到常数误差以内:
+  // 除数较长时截去两者的低位, 较短时在两者的低位补0, 使除数恰好有k位
+  int m = len, n = val.len, qlen = m - n + 1, k = qlen + 2;
+  sjtu::int2048 top, v;
+  if (n >= k)
+  {
+    top = Slice(n - k, m);
+    v = val.Slice(n - k, n);
+  }
+  else
+  {
+    top = *this << (k - n);
+    v = val << (k - n);
+  }
+  sjtu::int2048 inv = GetInv(v, k);
+  // 被除数同样只需要最高qlen + 2位
+  int drop = std::max(0, top.len - (qlen + 2));
+  top >>= drop;
+  sjtu::int2048 quotient = (top * inv) >> (2 * k - drop);
+  *this = Adjust(*this, val, quotient);
+  return quotient;
+}
+
+sjtu::int2048 &sjtu::int2048::UnsignedDivide(const sjtu::int2048 &val, sjtu::int2048 &rem)
 {
-  sjtu::int2048 divisor(abs(val));
   sgn = 1;
-  if (*this < divisor) return *this = 0;
-  if (len > 2 * val.len)
+  if (val.len == 1)
+  {
+    rem = DivideSmall(val.a[0]);
+    return *this;
+  }
+  if (val.len * base_log10 <= 18)
+  {
+    // 除数小于10^18时直接做短除法
+    unsigned long long divisor = 0;
+    for (int i = val.len - 1; i >= 0; --i) divisor = divisor * base + val.a[i];
+    rem = static_cast<long long>(DivideSmall(sjtu::reciprocal(divisor)));
+    return *this;
+  }
+  sjtu::int2048 divisor(abs(val));
+  if (*this < divisor)
   {
-    int delta = len - 2 * val.len;
-    *this = (*this << delta);
-    divisor = (divisor << delta);
+    rem = std::move(*this);
+    return *this = 0;
   }
-  int2048 inv(GetInv(divisor, divisor.len));
-  Adjust(int2048(1) << 2 * divisor.len, divisor, inv, 1e8);
-  int2048 ans = (*this * inv) >> (2 * divisor.len);
-  Adjust(*this, divisor, ans, 1e8);
-  return *this = ans;
+  // 将被除数与除数同乘f, 使除数的最高位不小于base / 2, 商不变
+  int f = base / (divisor.a[divisor.len - 1] + 1);
+  if (f > 1)
+  {
+    *this = *this * f;
+    divisor = divisor * f;
+  }
+  int size = std::min(divisor.len, len - divisor.len + 1);
+  sjtu::int2048 quotient;
+  if (size < INT2048_BZ_THRESHOLD) { quotient = SchoolDivide(divisor); }
+  else if (size < INT2048_NEWTON_THRESHOLD) { quotient = RecursiveDivide(divisor); }
+  else { quotient = NewtonDivide(divisor); }
+  // 各算法都把乘过f的余数留在当前数中
+  if (f > 1) DivideExactSmall(f);
+  rem = std::move(*this);
+  return *this = std::move(quotient);
 }
 
-sjtu::int2048 &sjtu::int2048::operator/=(const sjtu::int2048 &val)
+sjtu::int2048 &sjtu::int2048::div_rem(const sjtu::int2048 &val, sjtu::int2048 &rem)
+{
+  if (&val == this || &val == &rem)
+  {
+    sjtu::int2048 divisor(val);
+    return div_rem(divisor, rem);
+  }
+  if (val == 0)
+  {
+    rem = *this;
+    return *this = 0;
+  }
+  int new_sgn = sgn * val.sgn;
+  UnsignedDivide(val, rem);
+  if (new_sgn == -1 && !(rem.len == 1 && rem.a[0] == 0))
+  {
+    // 向下取整: 商的绝对值加1, 余数变为|val| - |rem|, 并与除数同号
+    *this += 1;
+    if (val.sgn == 1) { rem -= val; rem.sgn = 1; }
+    else { rem += val; }
+  }
+  else if (!(rem.len == 1 && rem.a[0] == 0))
+  {
+    rem.sgn = val.sgn;
+  }
+  sgn = new_sgn;
+  if (len == 1 && a[0] == 0) sgn = 1;
+  return *this;
+}
+
+std::pair<sjtu::int2048, sjtu::int2048> sjtu::divmod(const sjtu::int2048 &x, const sjtu::int2048 &y)
+{
+  std::pair<sjtu::int2048, sjtu::int2048> ret(x, 0);
+  ret.first.div_rem(y, ret.second);
+  return ret;
+}
+
+int sjtu::int2048::InverseModBase(int x)
+{
+  // 扩展欧几里得算法
+  long long r0 = base, r1 = x, t0 = 0, t1 = 1;
+  while (r1 != 0)
+  {
+    long long q = r0 / r1, r = r0 - q * r1, t = t0 - q * t1;
+    r0 = r1, r1 = r;
+    t0 = t1, t1 = t;
+  }
+  return static_cast<int>(t0 < 0 ? t0 + base : t0);
+}
+
+bool sjtu::int2048::StripBaseFactors(sjtu::int2048 &u, sjtu::int2048 &v, int limit)
+{
+  // 公因子g整除base, 故截断后的两数仍能被g整除
+  for (int rounds = 0; rounds <= limit; ++rounds)
+  {
+    int g = base, r = v.a[0];
+    while (r != 0)
+    {
+      int t = g % r;
+      g = r, r = t;
+    }
+    if (g == 1) return true;
+    u.DivideExactSmall(g);
+    v.DivideExactSmall(g);
+  }
+  return false;
+}
+
+sjtu::int2048 sjtu::HenselInverse(const sjtu::int2048 &val, int len)
+{
+  if (len == 1) return sjtu::int2048(sjtu::int2048::InverseModBase(val.a[0]));
+  // 若x * v = 1 + h * base^k (mod base^2k), 则x - x * h * base^k是模base^2k的逆元
+  int k = (len + 1) / 2;
+  sjtu::int2048 inv = HenselInverse(val, k);
+  sjtu::int2048 high = (val.Slice(0, len) * inv).Slice(k, len);
+  sjtu::int2048 fix = (inv * high).Slice(0, len - k);
+  if (fix.len == 1 && fix.a[0] == 0) return inv;
+  fix <<= k;
+  inv += sjtu::int2048(1) << len;
+  inv -= fix;
+  return inv.Slice(0, len);
+}
+
+sjtu::int2048 &sjtu::int2048::HenselDivide(const sjtu::int2048 &val, int n)
+{
+  // 两者末尾的0 block可以直接去掉, 之后只截取低位消去与base的公因子, 精度不够时加倍重试
+  int zeros = 0;
+  while (val.a[zeros] == 0) ++zeros;
+  sjtu::int2048 divisor;
+  for (int extra = 2; ; extra *= 2)
+  {
+    sjtu::int2048 dividend = Slice(zeros, zeros + n + extra);
+    divisor = val.Slice(zeros, zeros + n + extra);
+    if (StripBaseFactors(dividend, divisor, extra))
+    {
+      *this = std::move(dividend);
+      break;
+    }
+  }
+  if (std::min(n, divisor.len) >= INT2048_HENSEL_THRESHOLD)
+  {
+    return *this = (Slice(0, n) * HenselInverse(divisor, n)).Slice(0, n);
+  }
+  Reserve(n);
+  for (int i = len; i < n; ++i) a[i] = 0;
+  int m = std::min(divisor.len, n);
+  const long long inv = InverseModBase(divisor.a[0]);
+  for (int i = 0; i < n; ++i)
+  {
+    // 选取q使第i位恰好被消去, 被消去的位置正好用来存放q
+    long long q = a[i] * inv % base;
+    // 第0位乘积的低位恰好等于a[i], 只需把进位传下去
+    long long carry = q * divisor.a[0] / base, borrow = 0;
+    int top = std::min(m, n - i);
+    for (int j = 1; j < top; ++j)
+    {
+      long long prod = q * divisor.a[j] + carry;
+      carry = prod / base;
+      long long cur = a[i + j] - (prod - carry * base) - borrow;
+      borrow = (cur < 0);
+      a[i + j] = static_cast<int>(cur + borrow * base);
+    }
+    for (int j = top; j < n - i && (carry != 0 || borrow != 0); ++j)
+    {
+      long long cur = a[i + j] - carry - borrow;
+      carry = 0;
+      borrow = (cur < 0);
+      a[i + j] = static_cast<int>(cur + borrow * base);
+    }
+    a[i] = static_cast<int>(q);
+  }
+  len = n;
+  while (a[len - 1] == 0 && len >= 2) --len;
+  return *this;
+}
+
+sjtu::int2048 &sjtu::int2048::divexact(const sjtu::int2048 &val)
 {
   if (val == 0) return *this = 0;
-  int2048 dividend = *this;
-  int new_sgn = 1;
-  if (sgn != val.sgn) new_sgn = -1;
-  UnsignedDivide(val);
+  int new_sgn = sgn * val.sgn;
+  sgn = 1;
+  int qlen = len - val.len + 1;
+  int short_len = std::min(qlen, val.len);
+  if (qlen <= 0) { *this = 0; }
+  else if (val.len == 1) { DivideSmall(val.a[0]); }
+  else if (val.len * base_log10 <= 18)
+  {
+    // 除数小于10^18时短除法最快, 不需要截取和消去公因子
+    unsigned long long divisor = 0;
+    for (int i = val.len - 1; i >= 0; --i) divisor = divisor * base + val.a[i];
+    DivideSmall(sjtu::reciprocal(divisor));
+  }
+  else if (val.len >= INT2048_BZ_THRESHOLD && qlen >= 2 * val.len)
+  {
+    // 商远长于除数时逐位消去是平方复杂度, 不如按除数长度分段的Burnikel-Ziegler除法
+    sjtu::int2048 rem;
+    UnsignedDivide(val, rem);
+  }
+  else if (short_len < exact_split_len || short_len >= exact_full_len) { HenselDivide(val, qlen); }
+  else
+  {
+    // Jebelean的双向精确除法: 商的低h + 1位用Hensel除法从低位求出,
+    // 其余高位只需截取两者的高位做普通除法, 得到的结果至多差1, 再用第h位修正
+    int h = qlen / 2;
+    int drop = std::max(0, val.len - (qlen - h + 2));
+    sjtu::int2048 high = *this >> (drop + h), rem;
+    high.UnsignedDivide(val >> drop, rem);
+    HenselDivide(val, h + 1);
+    int diff = (len > h ? a[h] : 0) - high.a[0];
+    if (diff > base / 2) diff -= base;
+    if (diff < -base / 2) diff += base;
+    high += diff;
+    high <<= h;
+    if (len > h) len = h;
+    while (a[len - 1] == 0 && len >= 2) --len;
+    UnsignedAddAssign(high);
+  }
   sgn = new_sgn;
-  if (*this < 0 && dividend - *this * val != 0) *this -= 1;
   if (len == 1 && a[0] == 0) sgn = 1;
   return *this;
 }
 
+sjtu::int2048 sjtu::divexact(sjtu::int2048 x, const sjtu::int2048 &y)
+{
+  x.divexact(y);
+  return x;
+}
+
+bool sjtu::int2048::divisible(const sjtu::int2048 &val) const
+{
+  bool is_zero = (len == 1 && a[0] == 0);
+  if (val.len == 1 && val.a[0] == 0) return is_zero;
+  if (val.len * base_log10 <= 18)
+  {
+    // 只求余数, 不写回商
+    unsigned long long divisor = 0, rem = 0;
+    for (int i = val.len - 1; i >= 0; --i) divisor = divisor * base + val.a[i];
+    if (divisor < static_cast<unsigned long long>(base))
+    {
+      for (int i = len - 1; i >= 0; --i) rem = (rem * base + a[i]) % divisor;
+    }
+    else
+    {
+      sjtu::reciprocal rc(divisor);
+      for (int i = len - 1; i >= 0; --i)
+      {
+        unsigned __int128 cur = static_cast<unsigned __int128>(rem) * base + a[i];
+        rc.DivRem(static_cast<unsigned long long>(cur >> 64), static_cast<unsigned long long>(cur), rem);
+      }
+    }
+    return rem == 0;
+  }
+  if (len < val.len) return is_zero;
+  // 除数较长时, 验证Hensel商需要一次完整的乘法, 不如直接求余数
+  sjtu::int2048 quotient(abs(*this)), rem;
+  quotient.UnsignedDivide(val, rem);
+  return rem.len == 1 && rem.a[0] == 0;
+}
+
+long long sjtu::int2048::div_rem(long long val)
+{
+  if (val == 0)
+  {
+    *this = 0;
+    return 0;
+  }
+  int new_sgn = (val < 0) ? -sgn : sgn;
+  unsigned long long divisor = (val < 0) ? 0ull - static_cast<unsigned long long>(val) : val;
+  unsigned long long rem;
+  if (divisor < static_cast<unsigned long long>(base)) { rem = DivideSmall(static_cast<int>(divisor)); }
+  else { rem = DivideSmall(sjtu::reciprocal(divisor)); }
+  sgn = 1;
+  if (new_sgn == -1 && rem != 0)
+  {
+    // 向下取整, 同int2048版本的div_rem
+    *this += 1;
+    rem = divisor - rem;
+  }
+  sgn = new_sgn;
+  if (len == 1 && a[0] == 0) sgn = 1;
+  return static_cast<long long>(val < 0 ? 0ull - rem : rem);
+}
+
+unsigned long long sjtu::int2048::div_rem(const sjtu::reciprocal &val)
+{
+  int new_sgn = sgn;
+  unsigned long long rem = DivideSmall(val);
+  sgn = 1;
+  if (new_sgn == -1 && rem != 0)
+  {
+    *this += 1;
+    rem = val.divisor - rem;
+  }
+  sgn = new_sgn;
+  if (len == 1 && a[0] == 0) sgn = 1;
+  return rem;
+}
+
+sjtu::int2048 &sjtu::int2048::operator/=(const sjtu::int2048 &val)
+{
+  sjtu::int2048 rem;
+  return div_rem(val, rem);
+}
+
 sjtu::int2048 sjtu::operator/(sjtu::int2048 x, const sjtu::int2048& y)
 {
   x /= y;
@@ -704,12 +2561,38 @@ sjtu::int2048 sjtu::operator/(sjtu::int2048 x, const sjtu::int2048& y)
 
 sjtu::int2048 &sjtu::int2048::operator%=(const sjtu::int2048 &val)
 {
-  int2048 res = *this / val;
-  *this -= res * val;
+  if (&val == this) return *this = 0;
+  sjtu::int2048 quotient(std::move(*this));
+  quotient.div_rem(val, *this);
   return *this;
 }
 
 sjtu::int2048 sjtu::operator%(sjtu::int2048 x, const sjtu::int2048 &y)
+{
+  x %= y;
+  return x;
+}
+
+sjtu::int2048 &sjtu::int2048::operator/=(long long val)
+{
+  div_rem(val);
+  return *this;
+}
+
+sjtu::int2048 sjtu::operator/(sjtu::int2048 x, long long y)
+{
+  x /= y;
+  return x;
+}
+
+sjtu::int2048 &sjtu::int2048::operator%=(long long val)
+{
+  // 与int2048版本一致, 对0取模时保持不变
+  if (val == 0) return *this;
+  return *this = div_rem(val);
+}
+
+sjtu::int2048 sjtu::operator%(sjtu::int2048 x, long long y)
 {
   x %= y;
   return x;
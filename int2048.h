@@ -6,37 +6,118 @@
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <utility>
 #include <vector>
 
+// 压位的位数, 即每个block储存的十进制位数, 可在编译时通过-D覆盖, 取值为1~9
+#ifndef INT2048_BASE_LOG10
+#define INT2048_BASE_LOG10 9
+#endif
+
 namespace sjtu
 {
   class int2048;
+  /// 加减法与NTT蝶形运算所用的内核集合, 运行时按CPUID选择
+  enum class kernel_set { scalar, avx2, avx512 };
+  /// 返回当前使用的内核集合, 首次调用时检测CPU, 之后不再改变
+  kernel_set active_kernel_set();
+  /// 内核集合的名称, 即"scalar", "avx2"或"avx512"
+  const char *kernel_set_name(kernel_set);
+  /// 计算10^n, 用于在编译期确定压位的数字
+  constexpr int Pow10(int n) { return n == 0 ? 1 : 10 * Pow10(n - 1); }
+  /// 模数小于2^30时的Montgomery模乘, R = 2^32
+  class montgomery
+  {
+  public:
+    unsigned mod; // 模数
+    unsigned neg_inv; // -mod^(-1) mod 2^32
+    unsigned r2; // R^2 mod mod
+    explicit montgomery(unsigned);
+    /// 计算x * R^(-1) mod mod, 要求x < mod * R, 结果在[0, 2 * mod)内
+    unsigned Reduce(unsigned long long) const;
+    /// 计算x * y * R^(-1) mod mod, 要求x, y < 2 * mod
+    unsigned Mul(unsigned, unsigned) const;
+    /// 转换为Montgomery形式, 即x * R mod mod
+    unsigned ToForm(unsigned) const;
+    /// 将[0, 2 * mod)内的数规约到[0, mod)
+    unsigned Normalize(unsigned) const;
+    /// 快速幂, 底数与结果均为Montgomery形式
+    unsigned Pow(unsigned, unsigned) const;
+  };
+  /// 除数固定时的128 / 64位除法(Möller-Granlund), 用预先计算的倒数把除法指令换成乘法
+  class reciprocal
+  {
+  public:
+    unsigned long long divisor; // 除数, 不能为0
+    int shift; // 使除数最高位为1所需的左移位数
+    unsigned long long inv; // floor((2^128 - 1) / (divisor << shift)) - 2^64
+    explicit reciprocal(unsigned long long);
+    /// 计算(hi * 2^64 + lo) / divisor, 余数写入rem, 要求hi < divisor
+    unsigned long long DivRem(unsigned long long, unsigned long long, unsigned long long &) const;
+  };
   class polynomial
   {
   private:
-    // 使用NTT计算乘法, root = 6, mod = 7 * (2 ^ 50) + 1
-    constexpr static __int128 root = 6;
-    constexpr static __int128 inv = 1313549891316395;
-    constexpr static __int128 mod = 7881299347898369;
+    // 使用三模数NTT计算乘法, 模数均小于2^30且原根均为3, 最后用CRT合并
+    // 998244353 = 119 * 2^23 + 1, 167772161 = 5 * 2^25 + 1, 469762049 = 7 * 2^26 + 1
+    constexpr static int mod_cnt = 3;
+    constexpr static unsigned mod[mod_cnt] = {998244353, 167772161, 469762049};
+    constexpr static unsigned root = 3;
+    constexpr static int max_log = 23; // 变换长度最大为2^23, 受限于998244353
+    constexpr static int block_len = 4096; // 不超过此长度的子问题整体留在缓存中, 逐层迭代计算
+    constexpr static int radix4_chunk = 512; // 合并两层时每次处理的长度, 使4段数据留在L1中
+    constexpr static unsigned long long mod01 = 167477612308856833ull; // mod[0] * mod[1]
+    constexpr static unsigned long long inv0_1 = 47450712; // mod[0]^(-1) mod mod[1]
+    constexpr static unsigned long long inv01_2 = 115990628; // (mod[0] * mod[1])^(-1) mod mod[2]
     int len;
-    __int128 *a;
-    /// NTT 蝶形变换, O(n)
-    void ChangeIndex();
+    unsigned *a[mod_cnt]; // a[k]储存各系数模mod[k]的余数, 取值在[0, 2 * mod[k])内
+    /// 取得第k个模数下长度为2^(log + 1)的一层变换所用的单位根, 即w^0...w^(2^log - 1)
+    /// 单位根为Montgomery形式, 首次使用时生成, 之后全局缓存, 线程安全
+    static const unsigned *GetRoots(int k, int is_NTT, int log);
+    /// 一组长度为n的时域抽取(DIT)蝶形运算: (f0[j], f1[j]) = (f0[j] + w[j] * f1[j], f0[j] - w[j] * f1[j])
+    /// 取值保持在[0, 2 * mod)内
+    static void Butterfly(unsigned *, unsigned *, const unsigned *, int, const montgomery &);
+    /// Butterfly的各个实现, 由Butterfly按active_kernel_set()分派, 向量版本要求n是向量宽度的倍数
+    static void ButterflyScalar(unsigned *, unsigned *, const unsigned *, int, const montgomery &);
+    static void ButterflyAvx2(unsigned *, unsigned *, const unsigned *, int, const montgomery &);
+    static void ButterflyAvx512(unsigned *, unsigned *, const unsigned *, int, const montgomery &);
+    /// 一组长度为n的频域抽取(DIF)蝶形运算: (f0[j], f1[j]) = (f0[j] + f1[j], (f0[j] - f1[j]) * w[j]), 分派方式同上
+    static void ButterflyDif(unsigned *, unsigned *, const unsigned *, int, const montgomery &);
+    static void ButterflyDifScalar(unsigned *, unsigned *, const unsigned *, int, const montgomery &);
+    static void ButterflyDifAvx2(unsigned *, unsigned *, const unsigned *, int, const montgomery &);
+    static void ButterflyDifAvx512(unsigned *, unsigned *, const unsigned *, int, const montgomery &);
     /// 扩展多项式长度, 自动添加前缀0
     void ExtendLen(int);
-    /// 对当前多项式进行快速数论变换
-    void NTT(int);
-    /// 对多项式进行进位处理
-    void CalcCarry();
-    /// 带模数的快速幂
-    friend __int128 pow_mod(__int128, __int128);
-    /// 扩展欧几里得算法，用于计算模数
-    friend void Extend_GCD(__int128, __int128, __int128 &, __int128 &);
-    /// 求取模意义下的乘法逆元
-    friend __int128 inverse(__int128);
+    /// 对位逆序排列的f[0, n)由低到高做所有层的DIT蝶形运算, 结果为顺序排列
+    /// 超过block_len时先递归完成各子段, 再把最高的两层合并为一遍基4的蝶形运算
+    static void Stages(unsigned *, int, int k, int is_NTT, const montgomery &);
+    /// 对顺序排列的f[0, n)由高到低做所有层的DIF蝶形运算, 结果为位逆序排列, 分块方式与Stages对称
+    static void StagesDif(unsigned *, int, int k, int is_NTT, const montgomery &);
+    /// 用至多threads个线程对当前多项式进行快速数论变换
+    /// 正变换的结果为位逆序排列, 逆变换的输入也是位逆序排列, 因此逐点相乘前后都不需要重排
+    void NTT(int is_NTT, int threads);
+    /// 与一个已经做过正变换且长度相同的多项式逐点相乘, 再做逆变换
+    polynomial &PointwiseMultiply(const polynomial &);
+    /// 将*this与val都补零到长度n并做正变换, 长度足够时两者同时进行, 各分得一半线程
+    void PrepareBoth(polynomial &, int);
+    /// 多线程计算时使用的总线程数(包括调用者的线程)
+    static int ThreadCount();
+    /// 长度为n的变换可以使用的线程数, 短于INT2048_PARALLEL_THRESHOLD时为1
+    static int TransformThreads(int);
+    /// 常驻的工作线程池, 定义在int2048.cpp中
+    class thread_pool;
+    /// 所有ParallelFor共用的线程池, 首次调用时创建
+    static thread_pool &Pool();
+    /// 用当前线程和线程池中至多threads - 1个线程执行f(0), ..., f(n - 1)
+    /// threads <= 1时在当前线程中依次执行; f抛出的异常在所有线程离开后于当前线程重新抛出
+    template <class Func>
+    static void ParallelFor(int, int, const Func &);
+    /// 用CRT合并三个模数下的第i项系数, 结果小于2^87
+    unsigned __int128 CRT(int) const;
 
   public:
     friend class int2048;
+    constexpr static int max_len = 1 << max_log; // 变换长度的上限, 乘积更长时需要由调用者分段计算
     /// 默认构造函数, 默认构造f(x) = 0
     polynomial();
     /// 复制构造函数
@@ -45,6 +126,8 @@ namespace sjtu
     polynomial(polynomial &&) noexcept;
     /// 利用大整数生成多项式，即将x转换为f(x) = a0 + a1 * x + ...
     explicit polynomial(const int2048 &);
+    /// 利用一段block生成多项式, 定义同上
+    polynomial(const int *, int);
     /// 析构函数
     ~polynomial();
     /// 复制赋值运算
@@ -53,26 +136,144 @@ namespace sjtu
     polynomial &operator=(polynomial &&) noexcept;
     /// 进行多项式乘法
     polynomial &Multiply(polynomial);
+    /// 补零到给定长度(2的幂)后做正变换, 之后可以多次参与MultiplyPrepared
+    void Prepare(int);
+    /// 与一个已经Prepare过的多项式相乘, 乘积长度不能超过其长度
+    polynomial &MultiplyPrepared(const polynomial &);
+    /// 计算长度为n(2的幂, 不小于两者的长度)的循环卷积, 即模x^n - 1意义下的乘积
+    polynomial &MultiplyCyclic(polynomial, int);
+    /// 计算多项式的平方, 只需要一次正变换
+    polynomial &Square();
     /// 利用多项式生成大整数
     int2048 ToInteger();
   };
   class int2048
   {
   private:
-    const static int base = 10000; // 压位的数字
-    const static int base_log10 = 4; // 压位的位数
+    const static int base_log10 = INT2048_BASE_LOG10; // 压位的位数
+    const static int base = Pow10(base_log10); // 压位的数字
+    static_assert(base_log10 >= 1 && base_log10 <= 9, "a block must fit in an int");
+    const static int school_fold = 16; // 朴素乘法每累加这么多行就进位一次, 避免unsigned long long溢出
+    const static int school_buf_len = 256; // 朴素乘法使用栈上缓冲区的最大长度
+    const static int format_buf_len = 256; // 输出时使用栈上缓冲区的最大长度
+    const static int exact_split_len = 128; // 精确除法的商与除数都不短于此值时, 拆成高低两半分别计算
+    const static int exact_full_len = 4096; // 商与除数都不短于此值时, 整个商改为用Hensel除法求出
+    const static int small_len = 20 / base_log10 + 1; // 对象内部缓冲区的长度, 足以存下任意long long
     int len; // 数字长度，不包含前缀0
-    int *a; // 储存数据，0-based, 低位存在0
+    int cap; // a的容量, 即最多能储存的block数
+    int *a; // 储存数据，0-based, 低位存在0, 长度不超过small_len时指向small
+    int small[small_len]; // 对象内部的缓冲区, 避免小整数的堆分配
+    /// 使a至少能容纳n个block, 原有数据不保留, 容量足够时不重新分配
+    void Allocate(int);
+    /// 释放堆上的缓冲区, 令a指向small
+    void Release();
+    /// 使a至少能容纳n个block, 保留原有数据
+    void Reserve(int);
+    /// 同Reserve, 但容量按倍数增长, 使连续的增长均摊O(1)次分配
+    void Grow(int);
+    /// 将s[0, n)中的n(n <= 9)个数字转换为整数, 8个及以上时使用SWAR一次处理8个
+    static int ParseBlock(const char *, int);
+    /// 从s[0, n)中读入一个大整数, 允许前缀负号和前缀0
+    void Parse(const char *, int);
+    /// 将x补足前缀0后写为恰好n位数字
+    static void FormatBlock(char *, int, int);
+    /// 将当前数写入s中, 返回写入的字符数, s的长度至少为len * base_log10 + 1
+    int Format(char *) const;
+    /// 原地计算|*this| += |val|, 符号不变
+    void UnsignedAddAssign(const int2048 &);
+    /// 原地计算|*this| -= |val|, 要求|*this| >= |val|, 符号不变
+    void UnsignedMinusAssign(const int2048 &);
+    /// 原地计算|*this| = |val| - |*this|, 要求|val| >= |*this|, 符号不变
+    void UnsignedReverseMinusAssign(const int2048 &);
+    /// 比较两数的绝对值, 返回-1, 0或1
+    static int UnsignedCompare(const int2048 &, const int2048 &);
+    /// 原地加上符号为val_sgn, 绝对值为|val|的数, add与minus共用, 不构造取反的临时对象
+    void SignedAddAssign(const int2048 &, int);
     /// 无符号加法
     friend int2048 UnsignedAdd(const int2048 &, const int2048 &);
     /// 无符号减法
     friend int2048 UnsignedMinus(const int2048 &, const int2048 &);
-    /// 在牛顿迭代法之后进行误差调整
-    friend void Adjust(const int2048 &, const int2048&, int2048 &, long long);
-    /// 运用牛顿迭代法求逆，即求[2^n / x]
+    /// r[0, n) = x[0, n) + y[0, n), 返回最高位的进位, r可以与x或y相同
+    static int AddN(int *, const int *, const int *, int);
+    /// r[0, n) = x[0, n) - y[0, n), 返回最高位的借位, r可以与x或y相同
+    static int SubN(int *, const int *, const int *, int);
+    /// AddN与SubN的各个实现, 由AddN与SubN按active_kernel_set()分派
+    /// 向量版本先在向量内得到延迟的进位, 再由一次修正扫描传递
+    static int AddNScalar(int *, const int *, const int *, int);
+    static int SubNScalar(int *, const int *, const int *, int);
+    static int AddNAvx2(int *, const int *, const int *, int);
+    static int SubNAvx2(int *, const int *, const int *, int);
+    static int AddNAvx512(int *, const int *, const int *, int);
+    static int SubNAvx512(int *, const int *, const int *, int);
+    /// 向量内核处理完r[0, m)后调用: fix为真时修正[0, m)中溢出的位, 再用标量处理[m, n), 返回最终的进位或借位
+    static int AddNFinish(int *, const int *, const int *, int, int, int, bool);
+    static int SubNFinish(int *, const int *, const int *, int, int, int, bool);
+    /// 将x[0, n)加到r上, 进位向高位传递, 调用者需保证r有足够的空间
+    static void AddTo(int *, const int *, int);
+    /// 从r[0, n)中减去x[0, n), 借位向高位传递, 调用者需保证结果非负
+    static void MinusFrom(int *, const int *, int);
+    /// 将sum[0, n)进位使每一项小于base, 进位累加到sum[n]上
+    static void FoldCarry(unsigned long long *, int);
+    /// 朴素乘法, r[0, na + nb) = a[0, na) * b[0, nb)
+    static void SchoolMultiply(const int *, int, const int *, int, int *);
+    /// Karatsuba乘法, r[0, 2n) = a[0, n) * b[0, n), tmp为临时空间
+    static void KaratsubaMultiply(const int *, const int *, int, int *, int *);
+    /// 朴素平方, r[0, 2n) = a[0, n)^2, 交叉项只计算一次
+    static void SchoolSquare(const int *, int, int *);
+    /// Karatsuba平方, r[0, 2n) = a[0, n)^2, tmp为临时空间
+    static void KaratsubaSquare(const int *, int, int *, int *);
+    /// Toom-Cook 3路乘法, 计算|x| * |y|
+    friend int2048 Toom3Multiply(const int2048 &, const int2048 &);
+    /// 无符号乘法, 根据长度选择朴素乘法, Karatsuba, Toom-3或NTT
+    /// 默认阈值下不会用到Toom-3, 见int2048.cpp开头的说明
+    friend int2048 UnsignedMultiply(const int2048 &, const int2048 &);
+    /// 长度相差悬殊时的NTT乘法, 将x按照y的长度分段, y只需变换一次
+    /// y超过变换长度上限的一半时, 再将y分段后逐段计算并累加
+    friend int2048 UnbalancedMultiply(const int2048 &, const int2048 &);
+    /// 无符号平方, 选择算法的方式同UnsignedMultiply
+    friend int2048 UnsignedSquare(const int2048 &);
+    /// 除以一个较小的正整数, 要求能够整除
+    int2048 &DivideExactSmall(int);
+    /// 原地除以一个小于base的正整数, 返回余数
+    int DivideSmall(int);
+    /// 原地除以一个64位正整数, 返回余数
+    unsigned long long DivideSmall(const reciprocal &);
+    /// 取出第[l, r)个block组成的无符号整数
+    int2048 Slice(int, int) const;
+    /// 将当前的非负整数对base^n - 1取模
+    int2048 &ModWrap(int);
+    /// 当前数是某个绝对值小于base^(n - 1)的整数对base^n - 1取模的结果, 将其还原为该整数
+    /// 绝对值不满足条件时返回false
+    bool Unwrap(int);
+    /// 计算|x| * |y| mod (base^N - 1), 其中N >= n, 实际使用的N写回n; 长度足够时使用循环卷积
+    friend int2048 WrapMultiply(const int2048 &, const int2048 &, int &);
+    /// 在牛顿迭代法之后进行误差调整, 要求商的误差为常数个单位, 返回调整后的余数
+    friend int2048 Adjust(const int2048 &, const int2048 &, int2048 &);
+    /// 运用牛顿迭代法求逆，即求[base^(2n) / x]的近似值, 其中x为val的最高n个block
+    /// 要求val的最高位不小于base / 2, 误差不超过常数个单位
     friend int2048 GetInv(const int2048 &, int);
-    /// 无符号除法
-    int2048 &UnsignedDivide(const int2048 &);
+    /// Knuth算法D, 当前数变为余数, 返回商; 要求除数至少有2个block且最高位不小于base / 2
+    int2048 SchoolDivide(const int2048 &);
+    /// Burnikel-Ziegler递归除法中的2n / n步骤, a变为余数, 返回商; 要求a < b * base^n, 其中n为b的长度
+    friend int2048 Divide2n1n(int2048 &, const int2048 &);
+    /// Burnikel-Ziegler递归除法中的3n / 2n步骤, b = b1 * base^k + b2, 要求a < b * base^k
+    friend int2048 Divide3n2n(int2048 &, const int2048 &, const int2048 &, const int2048 &);
+    /// Burnikel-Ziegler递归除法, 将被除数按除数的长度分段后逐段做2n / n除法, 约定同SchoolDivide
+    int2048 RecursiveDivide(const int2048 &);
+    /// 基于牛顿迭代求逆的除法, 约定同SchoolDivide
+    int2048 NewtonDivide(const int2048 &);
+    /// 无符号除法, 根据长度选择单block除法, Knuth算法D, Burnikel-Ziegler或牛顿迭代
+    /// 当前数变为|*this| / |val|, rem变为|*this| % |val|
+    int2048 &UnsignedDivide(const int2048 &, int2048 &);
+    /// 求x在模base意义下的逆元, 要求x与base互质
+    static int InverseModBase(int);
+    /// 将u, v同时除以v的最低位与base的公因子, 直到v的最低位与base互质
+    /// 两者只需在低位上已知, 每一轮至多损失一个block的精度, 超过limit轮时返回false
+    static bool StripBaseFactors(int2048 &, int2048 &, int);
+    /// 2-adic牛顿迭代, 求val在模base^n意义下的逆元, 要求val的最低位与base互质
+    friend int2048 HenselInverse(const int2048 &, int);
+    /// Hensel精确除法, 当前数变为(*this / val) mod base^n, 只用到两者的低位, 要求能够整除
+    int2048 &HenselDivide(const int2048 &, int);
     /// 将当前整数*(base^x)（左移一个block)
     int2048 &operator<<=(int);
     /// 将当前整数/(base^x)（右移一个block)
@@ -90,7 +291,7 @@ namespace sjtu
     /// 基于long long的构造函数
     int2048(long long);
     /// 基于字符串的构造函数
-    explicit int2048(const std::string &);
+    int2048(const std::string &);
     /// 复制构造函数
     int2048(const int2048 &);
     /// 移动构造函数
@@ -98,8 +299,16 @@ namespace sjtu
     /// 析构函数
     ~int2048();
 
+    /// 预留至少能存下n位十进制数的空间, 保留原有的值
+    void reserve(int);
+
     /// 读入一个大整数
     void read(const std::string &);
+    /// 从[first, last)的开头读入一个大整数(可带负号), 返回第一个未被读入的字符
+    /// 如果开头不是合法的整数, 则不修改当前值并返回first
+    const char *parse(const char *, const char *);
+    /// 将当前数写入[first, last), 返回写入结束的位置, 空间不足时不写入并返回nullptr
+    char *format(char *, char *) const;
     /// 输出储存的大整数
     void print() const;
 
@@ -132,15 +341,39 @@ namespace sjtu
     int2048 &operator-=(const int2048 &);
     friend int2048 operator-(int2048, const int2048 &);
 
+    /// 将当前数平方
+    int2048 &square();
+    /// 返回一个大整数的平方
+    friend int2048 square(int2048);
+
     int2048 &operator*=(const int2048 &);
     friend int2048 operator*(int2048, const int2048 &);
     friend int2048 operator*(int2048, long long);
 
     int2048 &operator/=(const int2048 &);
     friend int2048 operator/(int2048, const int2048 &);
+    int2048 &operator/=(long long);
+    friend int2048 operator/(int2048, long long);
 
     int2048 &operator%=(const int2048 &);
     friend int2048 operator%(int2048, const int2048 &);
+    int2048 &operator%=(long long);
+    friend int2048 operator%(int2048, long long);
+
+    /// 同时计算商和余数, 当前数变为商, rem变为余数, 只做一次除法, 取整方式同/和%
+    /// rem不能与当前数是同一个对象
+    int2048 &div_rem(const int2048 &, int2048 &rem);
+    /// 返回{x / y, x % y}
+    friend std::pair<int2048, int2048> divmod(const int2048 &, const int2048 &);
+    /// 除以long long, 当前数变为商, 返回余数, 取整方式同上; 除数为0时当前数变为0并返回0
+    long long div_rem(long long);
+    /// 除以预先构造好倒数的正整数, 适合反复除以同一个数的场合, 当前数变为商, 返回余数
+    unsigned long long div_rem(const reciprocal &);
+    /// 已知能够整除时的除法, 从低位求商, 代价约为一次乘法; 不能整除时结果无意义
+    int2048 &divexact(const int2048 &);
+    friend int2048 divexact(int2048, const int2048 &);
+    /// 判断当前数能否被val整除, 0只能被0整除
+    bool divisible(const int2048 &) const;
 
     friend std::istream &operator>>(std::istream &, int2048 &);
     friend std::ostream &operator<<(std::ostream &, const int2048 &);
@@ -152,6 +385,14 @@ namespace sjtu
     friend bool operator<=(const int2048 &, const int2048 &);
     friend bool operator>=(const int2048 &, const int2048 &);
   };
+
+  // 只在类内声明为friend的函数不能用sjtu::限定名调用, 在这里再声明一次
+  int2048 square(int2048);
+  int2048 operator*(int2048, long long);
+  int2048 operator/(int2048, long long);
+  int2048 operator%(int2048, long long);
+  std::pair<int2048, int2048> divmod(const int2048 &, const int2048 &);
+  int2048 divexact(int2048, const int2048 &);
 } // namespace sjtu
 
 #endif
\ No newline at end of file
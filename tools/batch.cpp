@@ -0,0 +1,133 @@
+// 批量计算工具: 将输入文件映射到内存中直接解析, 逐行计算后写入预先映射好的输出文件
+// 输入的每一行为"<op> <a> <b>", op为+ - * / %时输出运算结果,
+// op为c时输出a与b比较的结果(-1, 0或1), 空行会被忽略
+// 用法: int2048_batch <input> <output>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <int2048.h>
+
+/// 跳过空格, 制表符与回车
+static const char *SkipBlank(const char *p, const char *end)
+{
+  while (p != end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+  return p;
+}
+
+/// 读入一个操作数, 失败时返回nullptr
+static const char *ReadOperand(const char *p, const char *end, sjtu::int2048 &x)
+{
+  p = SkipBlank(p, end);
+  const char *next = x.parse(p, end);
+  return next == p ? nullptr : next;
+}
+
+/// 逐行计算[in, in_end)中的运算, 结果写入out, 返回写入的字节数, 出错时返回-1
+static long Evaluate(const char *in, const char *in_end, char *out, char *out_end)
+{
+  sjtu::int2048 a, b, ret;
+  char *cur = out;
+  long line = 0;
+  for (const char *p = in; p != in_end; )
+  {
+    ++line;
+    p = SkipBlank(p, in_end);
+    if (p == in_end) break;
+    if (*p == '\n')
+    {
+      ++p;
+      continue;
+    }
+    char op = *p++;
+    if ((p = ReadOperand(p, in_end, a)) == nullptr || (p = ReadOperand(p, in_end, b)) == nullptr)
+    {
+      fprintf(stderr, "line %ld: expected two integers\n", line);
+      return -1;
+    }
+    p = SkipBlank(p, in_end);
+    if (p != in_end && *p++ != '\n')
+    {
+      fprintf(stderr, "line %ld: unexpected trailing characters\n", line);
+      return -1;
+    }
+    switch (op)
+    {
+      case '+': ret = a; ret += b; break;
+      case '-': ret = a; ret -= b; break;
+      case '*': ret = a * b; break;
+      case '/': ret = a / b; break;
+      case '%': ret = a % b; break;
+      case 'c': ret = (a < b) ? -1 : (a == b ? 0 : 1); break;
+      default:
+        fprintf(stderr, "line %ld: unknown operation '%c'\n", line, op);
+        return -1;
+    }
+    if ((cur = ret.format(cur, out_end)) == nullptr || cur == out_end)
+    {
+      fprintf(stderr, "line %ld: output buffer exhausted\n", line);
+      return -1;
+    }
+    *cur++ = '\n';
+  }
+  return cur - out;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc != 3)
+  {
+    fprintf(stderr, "usage: %s <input> <output>\n", argv[0]);
+    return 1;
+  }
+  int in_fd = open(argv[1], O_RDONLY);
+  if (in_fd < 0)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+  struct stat st;
+  fstat(in_fd, &st);
+  size_t in_size = st.st_size;
+  const char *in = "";
+  if (in_size != 0)
+  {
+    void *map = mmap(nullptr, in_size, PROT_READ, MAP_PRIVATE, in_fd, 0);
+    if (map == MAP_FAILED)
+    {
+      perror("mmap");
+      return 1;
+    }
+    madvise(map, in_size, MADV_SEQUENTIAL);
+    in = static_cast<const char *>(map);
+  }
+  // 每一行的结果都不会比这一行本身更长(最后一行可能缺少换行符), 因此输入的大小加上少量余量就足够了
+  size_t out_cap = in_size + 16;
+  int out_fd = open(argv[2], O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (out_fd < 0)
+  {
+    perror(argv[2]);
+    return 1;
+  }
+  if (ftruncate(out_fd, out_cap) != 0)
+  {
+    perror("ftruncate");
+    return 1;
+  }
+  void *out_map = mmap(nullptr, out_cap, PROT_READ | PROT_WRITE, MAP_SHARED, out_fd, 0);
+  if (out_map == MAP_FAILED)
+  {
+    perror("mmap");
+    return 1;
+  }
+  char *out = static_cast<char *>(out_map);
+  long written = Evaluate(in, in + in_size, out, out + out_cap);
+  munmap(out_map, out_cap);
+  if (in_size != 0) munmap(const_cast<char *>(in), in_size);
+  close(in_fd);
+  if (ftruncate(out_fd, written < 0 ? 0 : written) != 0) perror("ftruncate");
+  close(out_fd);
+  return written < 0 ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+// 性能测试工具: 对每种运算在不同的操作数长度下计时, 结果以JSON格式输出
+// 操作数长度以block数计, 默认从1个block按4倍增长到10^6个block
+// 用法: int2048_bench [--max-limbs N] [--min-time 秒] [--ops add,mul,...] [--out 文件]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include <int2048.h>
+
+static volatile bool sink; // 保存比较的结果, 防止比较被优化掉
+
+/// 生成一个恰好有n位的随机正整数
+static std::string RandomDigits(std::mt19937 &rng, long long n)
+{
+  std::string s(n, '0');
+  for (long long i = 0; i < n; ++i) s[i] = static_cast<char>('0' + rng() % 10);
+  s[0] = static_cast<char>('1' + rng() % 9);
+  return s;
+}
+
+/// 反复执行f直到总时间不少于min_time秒(至少执行一次), 返回每次执行的平均纳秒数和执行次数
+template <class Func>
+static double Measure(Func f, double min_time, long long &iterations)
+{
+  using clock = std::chrono::steady_clock;
+  iterations = 0;
+  auto start = clock::now();
+  double elapsed = 0;
+  long long batch = 1;
+  do
+  {
+    for (long long i = 0; i < batch; ++i) f();
+    iterations += batch;
+    elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    if (batch < (1ll << 20)) batch *= 2;
+  } while (elapsed < min_time);
+  return elapsed * 1e9 / iterations;
+}
+
+/// 判断ops中是否包含op, ops为空时包含所有运算
+static bool Selected(const std::string &ops, const char *op)
+{
+  if (ops.empty()) return true;
+  std::string list = "," + ops + ",";
+  return list.find("," + std::string(op) + ",") != std::string::npos;
+}
+
+int main(int argc, char **argv)
+{
+  long long max_limbs = 1000000;
+  double min_time = 0.2;
+  std::string ops;
+  const char *out_path = nullptr;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!strcmp(argv[i], "--max-limbs") && i + 1 < argc) { max_limbs = atoll(argv[++i]); }
+    else if (!strcmp(argv[i], "--min-time") && i + 1 < argc) { min_time = atof(argv[++i]); }
+    else if (!strcmp(argv[i], "--ops") && i + 1 < argc) { ops = argv[++i]; }
+    else if (!strcmp(argv[i], "--out") && i + 1 < argc) { out_path = argv[++i]; }
+    else
+    {
+      fprintf(stderr, "usage: %s [--max-limbs N] [--min-time SECONDS] [--ops add,sub,cmp,mul,sqr,div,mod,divmod,divexact,parse,print] [--out FILE]\n", argv[0]);
+      return 1;
+    }
+  }
+  FILE *out = out_path ? fopen(out_path, "w") : stdout;
+  if (out == nullptr)
+  {
+    perror(out_path);
+    return 1;
+  }
+  std::vector<long long> sizes;
+  for (long long n = 1; n < max_limbs; n *= 4) sizes.push_back(n);
+  sizes.push_back(max_limbs);
+  std::mt19937 rng(2048);
+  fprintf(out, "{\n  \"base_log10\": %d,\n  \"kernel_set\": \"%s\",\n  \"min_time\": %g,\n  \"results\": [",
+          INT2048_BASE_LOG10, sjtu::kernel_set_name(sjtu::active_kernel_set()), min_time);
+  bool first = true;
+  for (long long limbs : sizes)
+  {
+    long long digits = limbs * INT2048_BASE_LOG10;
+    std::string sa = RandomDigits(rng, digits), sb = RandomDigits(rng, digits);
+    // 除法与取模的被除数长度是除数的两倍
+    std::string sd = RandomDigits(rng, 2 * digits);
+    sjtu::int2048 a(sa), b(sb), d(sd), ret, rem;
+    // 精确除法的被除数是除数的倍数
+    sjtu::int2048 p = Selected(ops, "divexact") ? a * b : sjtu::int2048();
+    std::vector<char> buf(digits + 2);
+    struct Case { const char *op; std::function<void()> run; };
+    const Case cases[] = {
+      {"add", [&] { ret = a + b; }},
+      {"sub", [&] { ret = a - b; }},
+      {"cmp", [&] { sink = (a < b); }},
+      {"mul", [&] { ret = a * b; }},
+      {"sqr", [&] { ret = square(a); }},
+      {"div", [&] { ret = d / b; }},
+      {"mod", [&] { ret = d % b; }},
+      {"divmod", [&] { ret = d; ret.div_rem(b, rem); }},
+      {"divexact", [&] { ret = divexact(p, b); }},
+      {"parse", [&] { ret.parse(sa.data(), sa.data() + sa.size()); }},
+      {"print", [&] { a.format(buf.data(), buf.data() + buf.size()); }},
+    };
+    for (const Case &c : cases)
+    {
+      if (!Selected(ops, c.op)) continue;
+      long long iterations;
+      double ns = Measure(c.run, min_time, iterations);
+      fprintf(out, "%s\n    {\"op\": \"%s\", \"limbs\": %lld, \"iterations\": %lld, \"ns_per_op\": %.1f, \"limbs_per_s\": %.6g}",
+              first ? "" : ",", c.op, limbs, iterations, ns, limbs * 1e9 / ns);
+      first = false;
+      fflush(out);
+      fprintf(stderr, "%-8s %8lld limbs %14.1f ns/op\n", c.op, limbs, ns);
+    }
+  }
+  fprintf(out, "\n  ]\n}\n");
+  if (out != stdout) fclose(out);
+  return 0;
+}
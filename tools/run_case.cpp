@@ -0,0 +1,118 @@
+// 运行data/中的一个测试点: 重定向输入输出, 计时, 并与标准输出比较
+// 时间限制为factor * max(std_time, floor)秒, 超过时视为失败
+// 计时用子进程的CPU时间(user + sys), 不受exec开销和ctest -j下其他进程争抢的影响
+// 用法: int2048_run_case <程序> <输入文件|-> <输出文件> <标准输出|-> <std_time> <factor> <floor>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+/// 读入整个文件, 失败时返回false
+static bool ReadFile(const char *path, std::string &content)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+  std::ostringstream buf;
+  buf << file.rdbuf();
+  content = buf.str();
+  return true;
+}
+
+/// 返回s中从pos开始的一行, 不包含换行符
+static std::string LineAt(const std::string &s, size_t pos)
+{
+  size_t end = s.find('\n', pos);
+  if (end == std::string::npos) end = s.size();
+  std::string line = s.substr(pos, std::min<size_t>(end - pos, 80));
+  if (end - pos > 80) line += "...";
+  return line;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc != 8)
+  {
+    fprintf(stderr, "usage: %s <program> <input|-> <output> <expected|-> <std_time> <factor> <floor>\n", argv[0]);
+    return 2;
+  }
+  const char *program = argv[1], *input = argv[2], *output = argv[3], *expected = argv[4];
+  double std_time = atof(argv[5]), factor = atof(argv[6]), floor = atof(argv[7]);
+  double budget = factor * std::max(std_time, floor);
+
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid < 0)
+  {
+    perror("fork");
+    return 2;
+  }
+  if (pid == 0)
+  {
+    int in_fd = open(strcmp(input, "-") == 0 ? "/dev/null" : input, O_RDONLY);
+    int out_fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (in_fd < 0 || out_fd < 0)
+    {
+      perror("open");
+      _exit(127);
+    }
+    dup2(in_fd, STDIN_FILENO);
+    dup2(out_fd, STDOUT_FILENO);
+    execl(program, program, static_cast<char *>(nullptr));
+    perror("exec");
+    _exit(127);
+  }
+  int status;
+  struct rusage usage;
+  if (wait4(pid, &status, 0, &usage) < 0)
+  {
+    perror("wait4");
+    return 2;
+  }
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double elapsed = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6
+                   + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+  printf("cpu time %.3fs (wall %.3fs), budget %.3fs (%g x max(std Time %.2fs, %.2fs))\n", elapsed, wall, budget,
+         factor, std_time, floor);
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+  {
+    printf("FAIL: program exited abnormally (status %d)\n", status);
+    return 1;
+  }
+  if (strcmp(expected, "-") != 0)
+  {
+    std::string got, want;
+    if (!ReadFile(output, got) || !ReadFile(expected, want))
+    {
+      printf("FAIL: cannot read %s or %s\n", output, expected);
+      return 1;
+    }
+    if (got != want)
+    {
+      size_t pos = 0, line = 1;
+      while (pos < got.size() && pos < want.size() && got[pos] == want[pos])
+        if (got[pos++] == '\n') ++line;
+      size_t begin = got.rfind('\n', pos == 0 ? 0 : pos - 1);
+      begin = (begin == std::string::npos || pos == 0) ? 0 : begin + 1;
+      printf("FAIL: output differs at line %zu\n  got:      %s\n  expected: %s\n", line,
+             LineAt(got, begin).c_str(), LineAt(want, begin).c_str());
+      return 1;
+    }
+  }
+  if (elapsed > budget)
+  {
+    printf("FAIL: time limit exceeded\n");
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}